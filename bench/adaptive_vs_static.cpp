@@ -0,0 +1,43 @@
+#include "../pooler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#define BENCH_THREADS 4
+
+/* @brief Time one loop of 'items' indices of about 100 us each, in which thread 0 stalls for 200 ms on its first chunk
+ * @return	The time the loop took in milliseconds
+ */
+static double timeLoop(Pooler& pool, Pooler::Schedule schedule, Pooler::index_t items, std::atomic<long>& done) {
+	std::atomic<bool> stalled(false);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	pool.parallel_for(0, items, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+		if (id == 0 && !stalled.exchange(true)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+		for (Pooler::index_t i=range.begin;i<range.end;i++) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			done++;
+		}
+	}, nullptr, schedule, 10);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	const Pooler::index_t items = argc > 1 ? Pooler::index_t(std::atol(argv[1])) : 4000;
+	std::atomic<long> done(0);
+
+	Pooler pool(BENCH_THREADS);
+	const double staticMs = timeLoop(pool, Pooler::STATIC, items, done);
+	const double adaptiveMs = timeLoop(pool, Pooler::ADAPTIVE, items, done);
+	pool.stop();
+
+	printf("%d threads, %ld items of about 100 us, thread 0 stalled for 200 ms\n", BENCH_THREADS, long(items));
+	printf("%-10s %8.0f ms\n", "STATIC", staticMs);
+	printf("%-10s %8.0f ms\n", "ADAPTIVE", adaptiveMs);
+
+	return done.load() == 2 * long(items) ? 0 : 1;
+}
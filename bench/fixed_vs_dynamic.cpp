@@ -0,0 +1,70 @@
+#include "../pooler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The thread count both pools are built with. FixedPooler needs it at compile time
+#define BENCH_THREADS 4
+
+/* @brief Time a number of calls to a function, and return the average in microseconds
+ */
+template<class Func>
+double timeRuns(int runs, Func func) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i=0;i<runs;i++) {
+		func();
+	}
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+int main(int argc, char** argv) {
+	const int runs = argc > 1 ? std::atoi(argv[1]) : 20000;
+	const Pooler::index_t count = 1 << 16;
+
+	std::vector<float> values(count, 1.0f);
+	std::atomic<long> checksum(0);
+
+	Pooler pool(BENCH_THREADS);
+	FixedPooler<BENCH_THREADS> fixed;
+
+	// Dispatch cost alone: every thread runs an empty callback
+	const double poolEmpty = timeRuns(runs, [&]{
+		pool.run([](Pooler::threadid_t, void*) {});
+	});
+	const double fixedEmpty = timeRuns(runs, [&]{
+		fixed.run([](Pooler::threadid_t, void*) {});
+	});
+
+	// A short loop split into blocks, where the partitioning math is part of every run
+	const double poolBlocks = timeRuns(runs, [&]{
+		pool.run(Pooler::BlockPartition(count, BENCH_THREADS), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			float sum = 0;
+			for (Pooler::index_t i=range.begin;i<range.end;i++) {
+				sum += values[i];
+			}
+			checksum += long(sum);
+		});
+	});
+	const double fixedBlocks = timeRuns(runs, [&]{
+		fixed.run(Pooler::StaticBlockPartition<count, BENCH_THREADS>(), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			float sum = 0;
+			for (Pooler::index_t i=range.begin;i<range.end;i++) {
+				sum += values[i];
+			}
+			checksum += long(sum);
+		});
+	});
+
+	pool.stop();
+	fixed.stop();
+
+	printf("%d runs with %d threads\n", runs, BENCH_THREADS);
+	printf("%-28s %12s %16s\n", "", "Pooler", "FixedPooler<N>");
+	printf("%-28s %9.2f us %13.2f us\n", "empty callback", poolEmpty, fixedEmpty);
+	printf("%-28s %9.2f us %13.2f us\n", "sum of 65536 floats", poolBlocks, fixedBlocks);
+
+	// Keeps the loops from being optimized away
+	return checksum.load() == long(2) * runs * long(count) ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Track OpenMP regions through OMPT where the runtime has it. This file is the program's one POOLER_OMPT_TOOL
+#define POOLER_OMPT
+#define POOLER_OMPT_TOOL
+#include "../pooler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#ifndef _OPENMP
+#error "Build with OpenMP enabled, e.g. -fopenmp"
+#endif
+
+// The thread count of both the pool and the OpenMP team
+#define BENCH_THREADS 4
+
+/* @brief Spend a fixed amount of CPU, so the time taken grows when threads compete for cores
+ */
+static double work(int iterations) {
+	double x = 1.0;
+	for (int i=0;i<iterations;i++) {
+		x = x * 1.0000001 + 1e-9;
+	}
+	return x;
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Timing {
+	double region;
+	double loop;
+};
+
+/* @brief Run an ADAPTIVE loop on the pool, and an OpenMP region from another thread shortly after it starts
+ */
+static Timing measure(Pooler& pool, Pooler::Interop mode, int items, int itemWork, int regionWork, double& sink) {
+	pool.setInterop(mode);
+	Timing timing;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::thread openmp([&]{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		const std::chrono::steady_clock::time_point regionStart = std::chrono::steady_clock::now();
+		double regionSum = 0;
+		#pragma omp parallel num_threads(BENCH_THREADS) reduction(+:regionSum)
+		{
+			regionSum += work(regionWork);
+		}
+		timing.region = elapsed(regionStart);
+		sink += regionSum;
+	});
+
+	std::atomic<long> done(0);
+	pool.parallel_for(0, Pooler::index_t(items), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+		for (Pooler::index_t i=range.begin;i<range.end;i++) {
+			if (work(itemWork) > 0) {
+				done++;
+			}
+		}
+	}, nullptr, Pooler::ADAPTIVE, 1);
+	timing.loop = elapsed(start);
+
+	openmp.join();
+	sink += double(done.load());
+	return timing;
+}
+
+int main(int argc, char** argv) {
+	const int items = argc > 1 ? std::atoi(argv[1]) : 400;
+	const int itemWork = 200000;
+	const int regionWork = 20000000;
+	double sink = 0;
+
+	Pooler pool(BENCH_THREADS);
+
+	// Start the OpenMP team before timing anything
+	#pragma omp parallel num_threads(BENCH_THREADS)
+	{
+		sink += work(1000);
+	}
+
+#ifdef POOLER_OMPT
+	printf("OMPT: compiled in. OPENMP_SUSPEND parks the pool only if the runtime called ompt_start_tool()\n");
+#else
+	printf("OMPT: omp-tools.h not found, so OPENMP_SUSPEND acts like NATIVE\n");
+#endif
+	printf("%d loop items on %d pool threads, one OpenMP region on %d threads\n", items, BENCH_THREADS, BENCH_THREADS);
+	printf("%-16s %14s %14s\n", "", "region", "whole loop");
+
+	const Pooler::Interop modes[] = {Pooler::NATIVE, Pooler::OPENMP_SUSPEND};
+	const char* names[] = {"NATIVE", "OPENMP_SUSPEND"};
+	for (int m=0;m<2;m++) {
+		const Timing timing = measure(pool, modes[m], items, itemWork, regionWork, sink);
+		printf("%-16s %11.0f ms %11.0f ms\n", names[m], timing.region, timing.loop);
+	}
+
+	pool.stop();
+
+	// Keeps the work from being optimized away
+	return sink > 0 ? 0 : 1;
+}
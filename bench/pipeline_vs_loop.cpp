@@ -0,0 +1,52 @@
+#include "../pooler_pipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* @brief Time a number of calls to a function, and return the total in milliseconds
+ */
+template<class Func>
+double timeRuns(int runs, Func func) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i=0;i<runs;i++) {
+		func();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	const int runs = argc > 1 ? std::atoi(argv[1]) : 50;
+	const std::vector<float> values(1 << 22, 1.5f);
+	double checksum = 0;
+
+	// One thread, so the pipeline is compared with the same loop written by hand rather than with a parallel speedup
+	Pooler pool(1);
+
+	const double pipelineMs = timeRuns(runs, [&]{
+		checksum += pooler::pipeline(pool, values.begin(), values.end())
+			| pooler::transform([](float v) {return v * 2;})
+			| pooler::filter([](float v) {return v > 1;})
+			| pooler::reduce(0.0, [](double a, double b) {return a + b;});
+	});
+	const double handMs = timeRuns(runs, [&]{
+		double sum = 0;
+		for (float v : values) {
+			const float doubled = v * 2;
+			if (doubled > 1) {
+				sum += doubled;
+			}
+		}
+		checksum += sum;
+	});
+
+	pool.stop();
+
+	printf("%d runs over %d floats on one thread: transform, filter, then sum\n", runs, int(values.size()));
+	printf("%-12s %8.0f ms\n", "pipeline", pipelineMs);
+	printf("%-12s %8.0f ms\n", "hand loop", handMs);
+
+	// Keeps the loops from being optimized away
+	return checksum == 2 * runs * 3.0 * double(values.size()) ? 0 : 1;
+}
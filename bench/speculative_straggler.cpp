@@ -0,0 +1,53 @@
+#include "../pooler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define BENCH_THREADS 4
+
+int main() {
+	const Pooler::index_t items = 1000;
+	const Pooler::index_t grain = 10;
+
+	Pooler pool(BENCH_THREADS);
+	std::vector<double> out(items);
+
+	// Owned by compute, since the stalled copy of the first chunk is still running when the loop returns
+	std::shared_ptr<std::atomic<bool>> stalled = std::make_shared<std::atomic<bool>>(false);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	pool.parallel_for_speculative<std::vector<double>>(0, items, grain, 
+		[stalled](Pooler::threadid_t, const Pooler::Range& range, std::vector<double>& buffer, void*) {
+			if (!stalled->exchange(true)) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(300));
+			}
+			buffer.assign(range.end - range.begin, 0);
+			for (Pooler::index_t i=range.begin;i<range.end;i++) {
+				buffer[i - range.begin] = double(i);
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+		}, 
+		[&](Pooler::threadid_t, const Pooler::Range& range, std::vector<double>& buffer, void*) {
+			std::copy(buffer.begin(), buffer.end(), out.begin() + std::vector<double>::difference_type(range.begin));
+		});
+	const double returned = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	pool.wait();
+	const double settled = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	pool.stop();
+
+	printf("%d threads, %ld chunks of %ld items at 0.5 ms each, first chunk stalled for 300 ms\n", 
+		BENCH_THREADS, long(items / grain), long(grain));
+	printf("%-30s %8.0f ms\n", "returned after", returned);
+	printf("%-30s %8.0f ms\n", "stalled copy finished after", settled);
+
+	for (Pooler::index_t i=0;i<items;i++) {
+		if (out[i] != double(i)) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -34,6 +34,8 @@
 #include <cmath>
 
 #include <vector>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <thread>
 #include <mutex>
@@ -41,6 +43,35 @@
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <sstream>
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// OMPT needs a runtime that ships omp-tools.h, such as LLVM's libomp. GCC's libgomp doesn't, so POOLER_OMPT is dropped there
+#ifdef POOLER_OMPT
+#if defined(__has_include)
+#if !__has_include(<omp-tools.h>)
+#undef POOLER_OMPT
+#endif
+#endif
+#endif
+
+#ifdef POOLER_OMPT
+#include <omp-tools.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define __POOLER_ATFORK
+#endif
 
 #define __POOLER_FUNC_ARGS 	Pooler::threadid_t id, void* data
 
@@ -58,6 +89,211 @@
  */
 #define POOLER_LAMBDA [](__POOLER_FUNC_ARGS)->void
 
+#define __POOLER_RANGE_FUNC_ARGS 	Pooler::threadid_t id, const Pooler::Range& range, void* data
+
+/* @brief Define a new function that receives the range of indices assigned to its thread by a partition
+ * @param[in] callback	A name for this function variable; where 'callback' is the function name within <> in 'void <callback>(...) {...}'
+ * @param[out] id	A Pooler::threadid_t containing the id of the running thread, from 0 to N (where N is the pooler's thread count)
+ * @param[out] range	A Pooler::Range containing the indices this thread should process
+ * @param[out] data	A pointer to a shared struct provided at "run()"-time
+ */
+#define POOLER_RANGE_FUNC(callback, code) void callback(__POOLER_RANGE_FUNC_ARGS) code 
+
+/* @brief Define a range lambda function to be passed directly into "run()" alongside a partition
+ * @param[out] id	A Pooler::threadid_t containing the id of the running thread, from 0 to N (where N is the pooler's thread count)
+ * @param[out] range	A Pooler::Range containing the indices this thread should process
+ * @param[out] data	A pointer to a shared struct provided at "run()"-time
+ */
+#define POOLER_RANGE_LAMBDA [](__POOLER_RANGE_FUNC_ARGS)->void
+
+#define __POOLER_STRINGIFY(x) #x
+#define __POOLER_TOSTRING(x) __POOLER_STRINGIFY(x)
+
+/* @brief A Pooler::Site naming the source location it is written at, for loops tuned by call site
+ */
+#define POOLER_SITE Pooler::Site(__FILE__ ":" __POOLER_TOSTRING(__LINE__))
+
+#ifdef POOLER_OMPT
+/* @brief 	Tracks the OpenMP parallel regions active in the process through OMPT callbacks.
+ * @description Pools in Pooler::OPENMP_SUSPEND mode ask it to hold run() back, and to park their threads between chunks, until no region is active. 
+ * @description The callbacks are only registered if the program defines POOLER_OMPT_TOOL in exactly one translation unit, 
+ * @description and the OpenMP runtime supports OMPT (such as LLVM's libomp). Executables must export the symbol, e.g. by linking with -rdynamic. 
+ */
+class PoolerOpenMPRegions {
+	private:
+		static std::atomic<int>& active() {
+			static std::atomic<int> regions(0);
+			return regions;
+		}
+
+		// The number of non-initial implicit tasks this thread is executing, so a thread inside a region knows not to wait for it
+		static int& depth() {
+			static thread_local int tasks = 0;
+			return tasks;
+		}
+
+		static std::mutex& idleLock() {
+			static std::mutex lock;
+			return lock;
+		}
+
+		static std::condition_variable& idleCv() {
+			static std::condition_variable cv;
+			return cv;
+		}
+
+		static void parallelBegin(ompt_data_t*, const ompt_frame_t*, ompt_data_t*, unsigned int, int, const void*) {
+			active()++;
+		}
+
+		static void parallelEnd(ompt_data_t*, ompt_data_t*, int, const void*) {
+			if (--active() == 0) {
+				std::lock_guard<std::mutex> lock(idleLock());
+				idleCv().notify_all();
+			}
+		}
+
+		static void implicitTask(ompt_scope_endpoint_t endpoint, ompt_data_t*, ompt_data_t*, unsigned int, unsigned int, int flags) {
+			if (flags & ompt_task_initial) {
+				return;
+			}
+			depth() += (endpoint == ompt_scope_begin) ? 1 : -1;
+		}
+
+		static int initialize(ompt_function_lookup_t lookup, int, ompt_data_t*) {
+			ompt_set_callback_t setCallback = reinterpret_cast<ompt_set_callback_t>(lookup("ompt_set_callback"));
+			if (setCallback == nullptr) {
+				return 0;
+			}
+
+			setCallback(ompt_callback_parallel_begin, reinterpret_cast<ompt_callback_t>(&PoolerOpenMPRegions::parallelBegin));
+			setCallback(ompt_callback_parallel_end, reinterpret_cast<ompt_callback_t>(&PoolerOpenMPRegions::parallelEnd));
+			setCallback(ompt_callback_implicit_task, reinterpret_cast<ompt_callback_t>(&PoolerOpenMPRegions::implicitTask));
+			return 1;
+		}
+
+		static void finalize(ompt_data_t*) {}
+
+	public:
+		/* @brief Check whether the calling thread is running an implicit task of some OpenMP parallel region
+		 */
+		static bool inside() {
+			return depth() > 0;
+		}
+
+		/* @brief Block until no OpenMP parallel region is active
+		 * @description Returns immediately when called from inside a region, since that region can't end until this call returns
+		 */
+		static void waitForIdle() {
+			if (depth() > 0 || active() == 0) {
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(idleLock());
+			idleCv().wait(lock, []{return active() == 0;});
+		}
+
+		/* @brief The result handed to the OpenMP runtime by ompt_start_tool()
+		 */
+		static ompt_start_tool_result_t* startTool() {
+			static ompt_start_tool_result_t result = {&PoolerOpenMPRegions::initialize, &PoolerOpenMPRegions::finalize, {0}};
+			return &result;
+		}
+};
+
+#ifdef POOLER_OMPT_TOOL
+extern "C" ompt_start_tool_result_t* ompt_start_tool(unsigned int, const char*) {
+	return PoolerOpenMPRegions::startTool();
+}
+#endif
+#endif
+
+#ifdef __POOLER_ATFORK
+/* @brief 	The process-wide list of pools that are made safe across fork(). 
+ * @description Each pool registers a handler for each of the three points of pthread_atfork(), which is called on first use. 
+ * @description Pools are prepared in the order they registered in, and resumed in the parent in reverse. 
+ */
+class PoolerForkRegistry {
+	public:
+		typedef void (*handler_t)(void* pool);
+
+	private:
+		struct Entry {
+			void* pool;
+			handler_t prepare;
+			handler_t parent;
+			handler_t child;
+		};
+
+		static std::mutex& lock() {
+			static std::mutex registryLock;
+			return registryLock;
+		}
+
+		static std::vector<PoolerForkRegistry::Entry>& entries() {
+			static std::vector<PoolerForkRegistry::Entry> pools;
+			return pools;
+		}
+
+		/* @brief Quiesce every pool before fork(). Forking from inside a callback running on a pool deadlocks here. 
+		 */
+		static void prepareFork() {
+			PoolerForkRegistry::lock().lock();
+
+			for (const PoolerForkRegistry::Entry& entry : PoolerForkRegistry::entries()) {
+				entry.prepare(entry.pool);
+			}
+		}
+
+		/* @brief Resume every pool in the parent once fork() returns
+		 */
+		static void parentAfterFork() {
+			std::vector<PoolerForkRegistry::Entry>& pools = PoolerForkRegistry::entries();
+
+			for (std::vector<PoolerForkRegistry::Entry>::reverse_iterator entry=pools.rbegin();entry!=pools.rend();entry++) {
+				entry->parent(entry->pool);
+			}
+
+			PoolerForkRegistry::lock().unlock();
+		}
+
+		/* @brief Reset every pool in the child once fork() returns
+		 */
+		static void childAfterFork() {
+			for (const PoolerForkRegistry::Entry& entry : PoolerForkRegistry::entries()) {
+				entry.child(entry.pool);
+			}
+
+			new (&PoolerForkRegistry::lock()) std::mutex();
+		}
+
+	public:
+		/* @brief Add a pool to the list. The fork handlers are installed on first use. 
+		 * @param[in] pool	The pool, passed back to each handler
+		 * @param[in] prepare	Called before fork(). Must leave the pool quiet, with its locks held
+		 * @param[in] parent	Called in the parent after fork(). Must release what prepare took
+		 * @param[in] child	Called in the child after fork(), where only the forking thread exists
+		 */
+		static void add(void* pool, handler_t prepare, handler_t parent, handler_t child) {
+			static std::once_flag installed;
+			std::call_once(installed, []{
+				pthread_atfork(&PoolerForkRegistry::prepareFork, &PoolerForkRegistry::parentAfterFork, &PoolerForkRegistry::childAfterFork);
+			});
+
+			std::lock_guard<std::mutex> registryLock(PoolerForkRegistry::lock());
+			PoolerForkRegistry::entries().push_back(PoolerForkRegistry::Entry{pool, prepare, parent, child});
+		}
+
+		/* @brief Remove a pool from the list
+		 */
+		static void remove(void* pool) {
+			std::lock_guard<std::mutex> registryLock(PoolerForkRegistry::lock());
+			std::vector<PoolerForkRegistry::Entry>& pools = PoolerForkRegistry::entries();
+			pools.erase(std::remove_if(pools.begin(), pools.end(), [pool](const PoolerForkRegistry::Entry& entry) {return entry.pool == pool;}), pools.end());
+		}
+};
+#endif
+
 /* @brief 	The pooler class. Each instance of the pooler class is a separate thread pool.
  * @description Obviously, The pool is thread-safe by default. 
  * @description The pool can be made unsafe with irresponsible use of shared data in POOLER_FUNCs.
@@ -66,17 +302,99 @@ class Pooler {
 	// Typedefs 
 	public:
 		typedef uint16_t threadid_t;
+		typedef std::size_t index_t;
 		typedef std::function<void(threadid_t, void*)> func_t;
 
+		/* @brief 	A set of indices handed to one thread by a partition.
+		 * @description Indices start at 'begin' and come in runs of 'block' consecutive items spaced 'stride' apart, stopping before 'end'.
+		 * @description A contiguous range has block == stride == end - begin, so it can also be used as a plain [begin, end) pair. 
+		 */
+		struct Range {
+			index_t begin;
+			index_t end;
+			index_t block;
+			index_t stride;
+
+			/* @brief Call a function once for every index in this range, in increasing order
+			 * @param[in] f	A callable taking a Pooler::index_t
+			 */
+			template<class F>
+			void each(F f) const {
+				for (index_t first=this->begin;first<this->end;first+=this->stride) {
+					const index_t last = (this->end - first < this->block) ? this->end : first + this->block;
+
+					for (index_t i=first;i<last;i++) {
+						f(i);
+					}
+				}
+			}
+		};
+
+		typedef std::function<void(threadid_t, const Range&, void*)> range_func_t;
+
+		// How parallel_for() hands out the indices of a loop
+		enum Schedule {
+			STATIC,		// One contiguous block per thread
+			ADAPTIVE	// Each thread starts on its own block, and threads that run out steal the back half of the largest remaining block
+		};
+
+		// What a tuned parallel_for() learns about its call site. Combine with |
+		enum Tune {
+			TUNE_GRAIN = 1,		// The number of indices taken per chunk
+			TUNE_THREADS = 2	// The number of threads taking part, for loops that are bound by memory bandwidth rather than compute. 
+						// The threads left out are not free for other work while the loop runs
+		};
+
+		/* @brief 	Names the call site of a tuned parallel_for(), either with a tag chosen by the user or with POOLER_SITE
+		 * @description A const char* tag is remembered by its address after the first call, so it must be a string literal, or otherwise 
+		 * @description stay alive and unchanged as long as the pool. A std::string tag is copied, and looked up by its text on every call. 
+		 */
+		struct Site {
+			const char* literal;	// The tag when given as a const char*, otherwise nullptr
+			std::string tag;	// The tag when given as a std::string
+			unsigned tune;
+
+			Site(const char* tag, unsigned tune = TUNE_GRAIN) : literal(tag), tune(tune) {}
+			Site(const std::string& tag, unsigned tune = TUNE_GRAIN) : literal(nullptr), tag(tag), tune(tune) {}
+		};
+
+		// How the pool shares the machine with an OpenMP runtime in the same process
+		enum Interop {
+			NATIVE,		// Always run callbacks on the pool's own threads
+			OPENMP_BIND,	// Run callbacks on an OpenMP team, leaving the pool's threads parked. Needs OpenMP enabled, otherwise acts like NATIVE
+			OPENMP_SUSPEND	// Hold run() back, and park threads between the chunks of the pool's loops, while an OpenMP parallel region is active. 
+					// Needs POOLER_OMPT and a runtime with OMPT, otherwise acts like NATIVE. See yieldToOpenMP()
+		};
+
+		// Partitioning helpers, defined below the class
+		class Divider;
+		class BlockPartition;
+		class CyclicPartition;
+		class BlockCyclicPartition;
+		template<index_t COUNT, threadid_t THREADS> struct StaticBlockPartition;
+		template<class Cost> class WeightedPartition;
+
+		// Read-mostly shared data swapped by publishing, defined below the class
+		template<class T> class Rcu;
+
+		// One lazily constructed value per thread, defined below the class
+		template<class T> class local;
+
 	// Private vars and forward declarations
 	private:
 		// Store threads
 		std::vector<std::thread> _threads;
 		const Pooler::threadid_t _THREAD_COUNT;
 		
+		// Set when the threads must be started again before the next run(), such as in the child of a fork()
+		bool _respawn;
+		// Set when a run returned before every thread finished its callback
+		bool _runPending;
+
 		// Synchronization 
 		std::atomic<Pooler::threadid_t> _threadsComplete;
 		std::atomic<Pooler::threadid_t> _threadsWaiting;
+		std::mutex _runLock;
 		std::mutex _actionLock;
 		std::mutex _waitLock;
 		std::mutex _completeLock;
@@ -91,6 +409,10 @@ class Pooler {
 			STOP
 		} _action;
 
+		Interop _interop;
+		// Set for a run in OPENMP_SUSPEND mode started from outside any OpenMP region, so its threads may park between chunks
+		bool _suspendable;
+
 		/* @brief resetThreadLoop will initialize the condition lock variables
 		 */
 		void resetThreadLoop() {
@@ -118,67 +440,334 @@ class Pooler {
 			}
 			this->_actionCv.notify_all();
 		}
+
+		/* @brief Start every thread of the pool
+		 * @description If a thread can't be started, the ones that were are stopped and joined before the std::system_error is passed on. 
+		 */
+		void startThreads() {
+			try {
+				for (Pooler::threadid_t id=0;id<this->_THREAD_COUNT;id++) {
+					this->_threads.push_back(std::thread(&Pooler::threadAction, this, id));
+				}
+			} catch (...) {
+				// Destroying a joinable std::thread terminates the process, so the started threads must be joined first
+				{
+					std::lock_guard<std::mutex> lock(this->_actionLock);
+					this->_action = STOP;
+				}
+				this->_actionCv.notify_all();
+
+				for (std::thread& thread : this->_threads) {
+					thread.join();
+				}
+				this->_threads.clear();
+				this->resetThreadLoop();
+				throw;
+			}
+
+			this->_respawn = false;
+		}
 	
 		// A callback performed by each thread
 		Pooler::func_t _threadCallback;
 		// A pointer to some data structure 
 		void* _threadParam;
 
+		// What has been learned about one call site of a tuned parallel_for()
+		struct Tuning {
+			Pooler::index_t grain;		// The grain the next run will use, or 0 before the first run
+			Pooler::index_t bestGrain;
+			double bestCost;		// Nanoseconds per index at bestGrain, or 0 before the first measurement
+			double cost;			// Nanoseconds per index summed over the samples of the current grain
+			uint8_t samples;
+			int8_t direction;		// 1 while growing the grain, -1 while shrinking it, 0 once converged
+			bool reversed;
+
+			Pooler::threadid_t threads;	// The number of threads the next run will use, or 0 for all of them
+			Pooler::threadid_t bestThreads;
+			double bestThreadCost;		// Nanoseconds per index at bestThreads during the current probe
+			double threadCost;		// Nanoseconds per index summed over the samples of the current thread count
+			uint8_t threadSamples;
+			bool probing;			// True while thread counts are being probed. The grain is left alone meanwhile
+			uint32_t runsSinceProbe;
+
+			Tuning() : grain(0), bestGrain(0), bestCost(0), cost(0), samples(0), direction(1), reversed(false), 
+				threads(0), bestThreads(0), bestThreadCost(0), threadCost(0), threadSamples(0), probing(false), runsSinceProbe(TUNING_REPROBE) {}
+		};
+
+		// The number of runs averaged before each tuning step
+		static constexpr uint8_t TUNING_SAMPLES = 3;
+		// The number of runs between two probes of a TUNE_THREADS site, so it follows changes in the machine's load
+		static constexpr uint32_t TUNING_REPROBE = 1000;
+
+		// Keyed by tag text, for export and import. Nodes never move, so _tuningSites can point into them
+		std::map<std::string, Tuning> _tuning;
+		// The tuning of each const char* tag seen so far, by address, so a tuned loop doesn't build and compare strings
+		std::unordered_map<const char*, Tuning*> _tuningSites;
+		std::mutex _tuningLock;
+
+		// The epoch a thread entered its callback in, or last announced quiescence in, padded to its own cache line. 
+		// UINT64_MAX while the thread is outside any callback, where it can't hold a reference to anything retired
+		struct EpochSlot {
+			std::atomic<uint64_t> epoch;
+			char padding[64 - sizeof(std::atomic<uint64_t>)];
+		};
+
+		// An object waiting for every thread to move past the epoch it was retired in
+		struct Retired {
+			void* object;
+			void (*destroy)(void*);
+			uint64_t epoch;
+		};
+
+		// retire() tries to reclaim whenever this many more objects are waiting
+		static constexpr uint32_t RECLAIM_THRESHOLD = 64;
+
+		std::atomic<uint64_t> _epoch;
+		std::unique_ptr<Pooler::EpochSlot[]> _epochSlots;
+		std::vector<Pooler::Retired> _retired;
+		std::mutex _retireLock;
+
+		/* @brief Mark a thread as outside any callback
+		 */
+		void offline(Pooler::threadid_t id) {
+			this->_epochSlots[id].epoch = UINT64_MAX;
+		}
+
 	public:
 		/* @brief Construct a new pooler object
+		 * @description Throws std::system_error if the threads can't be started, once the ones that were have been joined. 
 		 * @param[in] threadCount	The number of threads this thread pool instance will use
 		 */
-		Pooler(Pooler::threadid_t threadCount) : _THREAD_COUNT(threadCount) {
+		Pooler(Pooler::threadid_t threadCount) : _THREAD_COUNT(threadCount), _respawn(false), _runPending(false), _interop(NATIVE), 
+			_suspendable(false), _epoch(0), _epochSlots(new Pooler::EpochSlot[threadCount]) {
 			this->resetThreadLoop();
 
-			// Start threads
 			for (Pooler::threadid_t id=0;id<threadCount;id++) {
-				this->_threads.push_back(std::thread(&Pooler::threadAction, this, id));
+				this->offline(id);
+			}
+
+			// Start threads
+			this->startThreads();
+
+#ifdef __POOLER_ATFORK
+			PoolerForkRegistry::add(this, [](void* pool) {static_cast<Pooler*>(pool)->prepareFork();}, 
+				[](void* pool) {static_cast<Pooler*>(pool)->parentAfterFork();}, [](void* pool) {static_cast<Pooler*>(pool)->childAfterFork();});
+#endif
+		}
+
+		~Pooler() {
+#ifdef __POOLER_ATFORK
+			PoolerForkRegistry::remove(this);
+#endif
+
+			for (const Pooler::Retired& retired : this->_retired) {
+				retired.destroy(retired.object);
 			}
 		}
 
-		~Pooler() {}
+		/* @brief Get the number of threads in this pool
+		 * @return	The thread count provided at construction
+		 */
+		Pooler::threadid_t threadCount() const {
+			return this->_THREAD_COUNT;
+		}
+
+		/* @brief Choose how this pool shares the machine with an OpenMP runtime. Must not be called during run(). 
+		 * @param[in] mode	One of the Pooler::Interop modes
+		 */
+		void setInterop(Pooler::Interop mode) {
+			this->_interop = mode;
+		}
+
+		Pooler::Interop interop() const {
+			return this->_interop;
+		}
+
+		/* @brief Park the calling thread while an OpenMP parallel region is active, if this pool is in OPENMP_SUSPEND mode
+		 * @description Call from a callback at a point where the thread holds nothing another thread waits on, such as between two chunks. 
+		 * @description The pool's ADAPTIVE, tuned and speculative loops already call it before each chunk. It does nothing if the run was 
+		 * @description started from inside a region, since that region can't end while the run lasts, or if POOLER_OMPT isn't in effect. 
+		 * @description A region must not itself wait on a run of this pool, or the two would wait on each other. 
+		 */
+		void yieldToOpenMP() const {
+#ifdef POOLER_OMPT
+			if (this->_suspendable) {
+				PoolerOpenMPRegions::waitForIdle();
+			}
+#endif
+		}
 
 		/* @brief Set the callback to perform in all threads, then signal each thread to perform the action. 
 		 * @param[in] callback	The callback function as defined in some POOLER_FUNC
 		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. Thread-safe by default. 
 		 */
 		void run(Pooler::func_t callback, void* newParam = nullptr) {
-			// Wait for all threads to begin waiting for the next action
-			this->waitForThreadsToFinish();
+			this->runUntil(callback, newParam, std::function<bool()>());
+		}
 
-			// Tell all the threads all the information they need to know
-			{
-				std::unique_lock<std::mutex> completeLock(this->_completeLock);
+		/* @brief Run an idempotent loop, letting idle threads duplicate straggling chunks so one slow thread can't hold up the whole loop
+		 * @description Chunks of 'grain' indices are handed out in order. Once all have been handed out, threads that run out of work 
+		 * @description compute the oldest chunks that haven't been committed yet a second time, each into their own buffer. Whichever copy of 
+		 * @description a chunk finishes first gets to commit it, and the other is thrown away. 
+		 * @description This returns as soon as every chunk is committed, so the loop takes as long as the fastest copy of its slowest chunk. 
+		 * @description A losing thread may still be inside 'compute' by then: the pool keeps its own copies of 'compute', 'commit' and the buffers 
+		 * @description until the next run() on this pool settles the losers, so 'compute' must own what it reads, by capturing it by value or 
+		 * @description through a std::shared_ptr, rather than referring to the caller's stack. 'commit' is never called after this returns. 
+		 * @param[in] begin	The first index of the loop
+		 * @param[in] end	One past the last index of the loop
+		 * @param[in] grain	The number of indices in each chunk
+		 * @param[in] compute	Computes a chunk into the calling thread's buffer. Must only write to the buffer. The buffer keeps its contents between chunks
+		 * @param[in] commit	Publishes a computed chunk from a buffer. Called exactly once per chunk, always before this returns
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. Must stay valid until the next run(), like 'compute's inputs
+		 * @param[in] Buffer	A default-constructible type holding a chunk's results. One is kept per thread
+		 */
+		template<class Buffer>
+		void parallel_for_speculative(Pooler::index_t begin, Pooler::index_t end, Pooler::index_t grain, 
+			std::function<void(Pooler::threadid_t, const Pooler::Range&, Buffer&, void*)> compute, 
+			std::function<void(Pooler::threadid_t, const Pooler::Range&, Buffer&, void*)> commit, void* newParam = nullptr) {
+			// Shared with the threads rather than kept on this stack, since a losing thread may still use it after this returns
+			struct Speculation {
+				Pooler::index_t begin;
+				Pooler::index_t end;
+				Pooler::index_t grain;
+				Pooler::index_t chunks;
+				std::atomic<Pooler::index_t> next;
+				std::atomic<Pooler::index_t> committed;
+				std::vector<std::atomic<bool>> done;
+				std::vector<std::atomic<bool>> duplicated;
+				std::vector<Buffer> buffers;
+				std::function<void(Pooler::threadid_t, const Pooler::Range&, Buffer&, void*)> compute;
+				std::function<void(Pooler::threadid_t, const Pooler::Range&, Buffer&, void*)> commit;
 
-				this->_threadsWaiting = 0;
+				Speculation(Pooler::index_t begin, Pooler::index_t end, Pooler::index_t grain, Pooler::threadid_t threads) : 
+					begin(begin), end(end), grain(grain), chunks((end - begin + grain - 1) / grain), next(0), committed(0), 
+					done(chunks), duplicated(chunks), buffers(threads) {
+					for (Pooler::index_t chunk=0;chunk<this->chunks;chunk++) {
+						this->done[chunk] = false;
+						this->duplicated[chunk] = false;
+					}
+				}
+			};
 
-				// While the completeLock is locked, tell the threads to start.
-				// No threads can finish before we have a chance to grab the completeLock, because we already have it. 
-				{
-					std::lock_guard<std::mutex> lock(this->_actionLock);
-					this->_threadCallback = callback;
-					this->_threadParam = newParam;
-					this->_action = RUN;
+			if (end <= begin) {
+				return;
+			}
+
+			std::shared_ptr<Speculation> speculation = std::make_shared<Speculation>(begin, end, std::max<Pooler::index_t>(grain, 1), this->_THREAD_COUNT);
+			speculation->compute = compute;
+			speculation->commit = commit;
+
+			this->runUntil([this, speculation](Pooler::threadid_t id, void* data) {
+				Speculation& state = *speculation;
+				Buffer& buffer = state.buffers[id];
+
+				auto execute = [&](Pooler::index_t chunk) {
+					this->yieldToOpenMP();
+
+					const Pooler::index_t first = state.begin + chunk * state.grain;
+					const Pooler::index_t last = std::min(first + state.grain, state.end);
+					const Pooler::Range range = Pooler::Range{first, last, last - first, last - first};
+
+					state.compute(id, range, buffer, data);
+
+					bool expected = false;
+					if (state.done[chunk].compare_exchange_strong(expected, true)) {
+						state.commit(id, range, buffer, data);
+						if (++state.committed == state.chunks) {
+							this->notifyComplete();
+						}
+					}
+				};
+
+				// Take fresh chunks in order
+				for (Pooler::index_t chunk=state.next++;chunk<state.chunks;chunk=state.next++) {
+					execute(chunk);
 				}
-					
-				// Notify the threads to start processing using this data and the previous iteration's samples
-				this->_actionCv.notify_all();
 
-				// Yield this thread's execution status
-				std::this_thread::yield();
+				// Every chunk has been handed out. Duplicate the oldest ones still outstanding, once each
+				for (Pooler::index_t chunk=0;chunk<state.chunks && state.committed < state.chunks;chunk++) {
+					if (!state.done[chunk] && !state.duplicated[chunk].exchange(true)) {
+						execute(chunk);
+					}
+				}
+			}, newParam, [speculation]{return speculation->committed == speculation->chunks;});
+		}
 
-				// Wait for all threads to complete
-				this->_completeCv.wait(completeLock, [&]{return this->_threadsComplete == this->_THREAD_COUNT;});
+		/* @brief Block until every thread has returned from its last callback
+		 * @description Only needed after parallel_for_speculative(), which can return while a thread is still computing a losing copy of a chunk
+		 */
+		void wait() {
+			std::lock_guard<std::mutex> runLock(this->_runLock);
+			if (!this->_respawn) {
+				this->settlePendingRun();
+				this->waitForThreadsToFinish();
 			}
+		}
 
-			// Set the action back to idle, telling the threads to go back to the start in the process. 
-			this->tellThreadsToIdle();
+		/* @brief Run a range callback in all threads, handing each thread the range a partition assigned to it
+		 * @param[in] partition	A partition built for this pool's thread count, such as a Pooler::BlockPartition
+		 * @param[in] callback	The callback function as defined in some POOLER_RANGE_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 */
+		template<class Partition>
+		auto run(const Partition& partition, Pooler::range_func_t callback, void* newParam = nullptr) -> decltype(partition.range(Pooler::threadid_t()), void()) {
+			this->run([&](Pooler::threadid_t id, void* data) {
+				callback(id, partition.range(id), data);
+			}, newParam);
 		}
 
+		/* @brief Split the loop [begin, end) between all threads, and run a range callback over each piece
+		 * @description With the STATIC schedule the callback is called once per thread, with that thread's block. 
+		 * @description With the ADAPTIVE schedule it is called once per chunk of at most 'grain' contiguous indices. 
+		 * @param[in] begin	The first index of the loop
+		 * @param[in] end	One past the last index of the loop
+		 * @param[in] callback	The callback function as defined in some POOLER_RANGE_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 * @param[in] schedule	How the indices are handed out, as listed in the Schedule enum
+		 * @param[in] grain	The number of indices an ADAPTIVE thread takes from its range at a time. 0 picks one from the loop size
+		 */
+		void parallel_for(Pooler::index_t begin, Pooler::index_t end, Pooler::range_func_t callback, void* newParam = nullptr, 
+			Pooler::Schedule schedule = STATIC, Pooler::index_t grain = 0);
+
+		/* @brief Run an ADAPTIVE loop whose grain is tuned for its call site over successive calls
+		 * @description Each call measures the time per index and how long threads sat idle at the end of the loop. The grain is then walked in 
+		 * @description powers of two, starting smaller when idle time dominates and larger when it doesn't, until neither direction is faster. 
+		 * @description Sites tagged with TUNE_THREADS first probe how many threads give the best throughput, every TUNING_REPROBE runs. 
+		 * @description Threads left out of such a loop return from it straight away instead of competing for memory bandwidth. 
+		 * @description They can't pick up other work meanwhile: a pool runs one callback on all of its threads at a time, so they stay parked in 
+		 * @description this loop's run and a run() from any other thread waits until the loop ends. The gain is only the lower contention. 
+		 * @param[in] site	The call site, such as POOLER_SITE, Pooler::Site("my-loop") or Pooler::Site("copy", Pooler::TUNE_THREADS)
+		 * @param[in] begin	The first index of the loop
+		 * @param[in] end	One past the last index of the loop
+		 * @param[in] callback	The callback function as defined in some POOLER_RANGE_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 */
+		void parallel_for(const Pooler::Site& site, Pooler::index_t begin, Pooler::index_t end, Pooler::range_func_t callback, void* newParam = nullptr);
+
+		/* @brief Save what has been learned about every tuned call site
+		 * @return	One line per site: the tag, then tab-separated key=value settings
+		 */
+		std::string exportTuning();
+
+		/* @brief Load settings saved by exportTuning(), so a new process starts out tuned. Imported sites are not tuned any further. 
+		 * @description A saved thread count is only used by sites tagged with TUNE_THREADS. 
+		 * @param[in] tuning	The text returned by exportTuning()
+		 */
+		void importTuning(const std::string& tuning);
+
 		/* @brief Wait for all threads to finish their job, tell the threads to perform a STOP command, then wait for all threads to terminate 
 		 */
 		void stop() {
+			std::lock_guard<std::mutex> runLock(this->_runLock);
+
+			// The child of a fork() has no threads to stop until its first run
+			if (this->_respawn) {
+				this->_respawn = false;
+				return;
+			}
+
+			this->settlePendingRun();
 			this->waitForThreadsToFinish();
 
 			// Send stop command to all threads
@@ -194,43 +783,301 @@ class Pooler {
 			}
 
 			this->_threads.clear();
+			this->reclaim();
 		}
-	
-	private:
 
-		/* @brief The action that threads in the pool perform until a joinall/STOP command. 
-		 * @description 	Waits for RUN commands, performs action, then signals complete
-		 * @param[in] threadID	ID of this thread. Thread #1 is index 0
+		/* @brief Hand an object to the pool to delete once no callback can still be using it
+		 * @description Callbacks may keep pointers to shared objects that another thread unlinks and retires. The pool deletes 
+		 * @description the object once every thread has left the callback it was in when the object was retired, or has called quiescent(). 
+		 * @description Run boundaries are quiescent points, so everything retired during a run is deleted when the run ends. 
+		 * @description Only the pool's own threads are tracked: other threads must not keep pointers to retired objects. 
+		 * @param[in] object	An object created with new, already unreachable by callbacks that start from now on
 		 */
-		void threadAction(Pooler::threadid_t threadID) {
-			// Threads will loop forever, waiting for instructions from the main thread
-			while (true) {
-				// -- CRITICAL SECTION -- 
-				{
-					// We will be waiting for commands
-					std::unique_lock<std::mutex> lock(this->_actionLock);
-					
-					{
-						std::lock_guard<std::mutex> waitLock(this->_waitLock);
-						this->_threadsWaiting++;
-					}
-					this->_waitCv.notify_all();
+		template<class T>
+		void retire(T* object) {
+			if (object == nullptr) {
+				return;
+			}
 
-					
-					// Now wait for a command
-					this->_actionCv.wait(lock, [&]{return this->_action != WAIT;});
+			bool full;
+			{
+				std::lock_guard<std::mutex> lock(this->_retireLock);
+				this->_retired.push_back(Pooler::Retired{object, [](void* retired) {delete static_cast<T*>(retired);}, this->_epoch++});
+				full = this->_retired.size() % RECLAIM_THRESHOLD == 0;
+			}
 
-					if (this->_action == STOP) {
-						break; // Stop the loop
-					} 
+			if (full) {
+				this->reclaim();
+			}
+		}
+
+		/* @brief Announce from inside a long callback that this thread holds no references to shared objects, so older retired objects can go
+		 * @param[in] id	The id of the calling thread
+		 */
+		void quiescent(Pooler::threadid_t id) {
+			this->_epochSlots[id].epoch = this->_epoch.load();
+		}
+
+		/* @brief Delete every retired object that no thread can still be using. Called by the pool at the end of every run
+		 * @description Objects are deleted on the calling thread, so their destructors must not run() on this pool. 
+		 */
+		void reclaim() {
+			std::vector<Pooler::Retired> ready;
+			{
+				std::lock_guard<std::mutex> lock(this->_retireLock);
+				if (this->_retired.empty()) {
+					return;
 				}
 
-				// Do Thread action
-				this->_threadCallback(threadID, this->_threadParam);
-				
-				// Signal to the main thread that we have finished work. 
-				{
-					std::unique_lock<std::mutex> lock(this->_actionLock);
+				uint64_t oldest = UINT64_MAX;
+				for (Pooler::threadid_t id=0;id<this->_THREAD_COUNT;id++) {
+					oldest = std::min<uint64_t>(oldest, this->_epochSlots[id].epoch.load());
+				}
+
+				// Objects retired before the oldest epoch a thread is in can't be seen by any thread
+				std::vector<Pooler::Retired> waiting;
+				for (const Pooler::Retired& retired : this->_retired) {
+					(retired.epoch < oldest ? ready : waiting).push_back(retired);
+				}
+				this->_retired.swap(waiting);
+			}
+
+			for (const Pooler::Retired& retired : ready) {
+				retired.destroy(retired.object);
+			}
+		}
+	
+	private:
+		/* @brief Perform a callback in all threads, and return once they have all finished or an early-completion condition holds
+		 * @param[in] callback	The callback function as defined in some POOLER_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 * @param[in] finished	Checked whenever notifyComplete() is called. May be empty
+		 */
+		void runUntil(Pooler::func_t callback, void* newParam, const std::function<bool()>& finished) {
+			// Only one run at a time. This also lets a fork() wait for the pool to go quiet
+			std::lock_guard<std::mutex> runLock(this->_runLock);
+
+#ifdef POOLER_OMPT
+			if (this->_interop == OPENMP_SUSPEND) {
+				PoolerOpenMPRegions::waitForIdle();
+			}
+#endif
+
+			// The child of a fork() starts its threads on the first run
+			if (this->_respawn) {
+				this->startThreads();
+			}
+
+			// Wait for all threads to begin waiting for the next action
+			this->settlePendingRun();
+			this->waitForThreadsToFinish();
+
+#ifdef POOLER_OMPT
+			this->_suspendable = (this->_interop == OPENMP_SUSPEND) && !PoolerOpenMPRegions::inside();
+#endif
+
+#ifdef _OPENMP
+			if (this->_interop == OPENMP_BIND) {
+				this->runOnOpenMP(callback, newParam);
+				this->reclaim();
+				return;
+			}
+#endif
+
+			// Tell all the threads all the information they need to know
+			bool pending;
+			{
+				std::unique_lock<std::mutex> completeLock(this->_completeLock);
+
+				this->_threadsWaiting = 0;
+
+				// While the completeLock is locked, tell the threads to start.
+				// No threads can finish before we have a chance to grab the completeLock, because we already have it. 
+				{
+					std::lock_guard<std::mutex> lock(this->_actionLock);
+					this->_threadCallback = callback;
+					this->_threadParam = newParam;
+					this->_action = RUN;
+				}
+					
+				// Notify the threads to start processing using this data and the previous iteration's samples
+				this->_actionCv.notify_all();
+
+				// Yield this thread's execution status
+				std::this_thread::yield();
+
+				// Wait for all threads to complete, or for the caller's condition
+				this->_completeCv.wait(completeLock, [&]{return this->_threadsComplete == this->_THREAD_COUNT || (finished && finished());});
+				pending = this->_threadsComplete != this->_THREAD_COUNT;
+			}
+
+			// Threads still inside the callback are left to finish it, and the next run sends them back to idle
+			if (pending) {
+				this->_runPending = true;
+				this->reclaim();
+				return;
+			}
+
+			// Set the action back to idle, telling the threads to go back to the start in the process. 
+			this->tellThreadsToIdle();
+			this->reclaim();
+		}
+
+		/* @brief Wait for the threads still inside the callback of a run that returned early, then send every thread back to idle
+		 */
+		void settlePendingRun() {
+			if (!this->_runPending) {
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> completeLock(this->_completeLock);
+				this->_completeCv.wait(completeLock, [&]{return this->_threadsComplete == this->_THREAD_COUNT;});
+			}
+
+			this->_runPending = false;
+			this->tellThreadsToIdle();
+		}
+
+		/* @brief Wake the thread waiting in runUntil() so it checks its early-completion condition again
+		 */
+		void notifyComplete() {
+			{
+				std::lock_guard<std::mutex> completeLock(this->_completeLock);
+			}
+			this->_completeCv.notify_all();
+		}
+
+		// The unclaimed part of one thread's range in an ADAPTIVE loop, padded to its own cache line. 
+		// Begin is packed in the high 32 bits and end in the low 32 bits, so owners and thieves can both claim from it with one compare-and-swap
+		struct StealSlot {
+			std::atomic<uint64_t> bounds;
+			char padding[64 - sizeof(std::atomic<uint64_t>)];
+		};
+
+		void runAdaptive(Pooler::index_t first, uint32_t count, const Pooler::range_func_t& callback, void* newParam, uint32_t grain, Pooler::threadid_t active);
+
+		// The time a thread finished its last chunk of a tuned loop, padded to its own cache line
+		struct FinishTime {
+			std::chrono::steady_clock::time_point at;
+			char padding[64 - sizeof(std::chrono::steady_clock::time_point)];
+		};
+
+		Pooler::Tuning& tuningOf(const Pooler::Site& site);
+		void tuneGrain(Pooler::Tuning& tuning, Pooler::index_t count, double cost, double idle);
+		void tuneThreads(Pooler::Tuning& tuning, double cost);
+
+#ifdef __POOLER_ATFORK
+		/* @brief Quiesce the pool before fork(): wait for any run() in progress, then for every thread to go idle, and hold the locks
+		 */
+		void prepareFork() {
+			this->_runLock.lock();
+			if (!this->_respawn) {
+				this->settlePendingRun();
+				this->waitForThreadsToFinish();
+			}
+			this->_actionLock.lock();
+			this->_retireLock.lock();
+			this->_tuningLock.lock();
+		}
+
+		/* @brief Resume the pool in the parent once fork() returns
+		 */
+		void parentAfterFork() {
+			this->_tuningLock.unlock();
+			this->_retireLock.unlock();
+			this->_actionLock.unlock();
+			this->_runLock.unlock();
+		}
+
+		/* @brief Reset the pool in the child once fork() returns. 
+		 * @description The child only inherits the forking thread, so the other threads' std::thread handles are abandoned without being joined, 
+		 * @description and every mutex and condition variable is rebuilt, since they may still reference the threads that no longer exist. 
+		 * @description Threads are started again by the next run(). 
+		 */
+		void childAfterFork() {
+			if (!this->_threads.empty()) {
+				this->_respawn = true;
+			}
+			this->_runPending = false;
+
+			for (std::thread& thread : this->_threads) {
+				new (&thread) std::thread();
+			}
+			this->_threads.clear();
+
+			new (&this->_runLock) std::mutex();
+			new (&this->_actionLock) std::mutex();
+			new (&this->_waitLock) std::mutex();
+			new (&this->_completeLock) std::mutex();
+			new (&this->_actionCv) std::condition_variable();
+			new (&this->_waitCv) std::condition_variable();
+			new (&this->_completeCv) std::condition_variable();
+			new (&this->_retireLock) std::mutex();
+			new (&this->_tuningLock) std::mutex();
+			this->resetThreadLoop();
+
+			for (Pooler::threadid_t id=0;id<this->_THREAD_COUNT;id++) {
+				this->offline(id);
+			}
+		}
+#endif
+
+#ifdef _OPENMP
+		/* @brief Perform a callback once for every thread id on an OpenMP team instead of the pool's threads
+		 * @param[in] callback	The callback function as defined in some POOLER_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 */
+		void runOnOpenMP(const Pooler::func_t& callback, void* newParam) {
+			const int threads = this->_THREAD_COUNT;
+
+			#pragma omp parallel num_threads(threads)
+			{
+				// The runtime may hand out fewer threads than requested, so each OpenMP thread covers every id congruent to its own
+				for (int id=omp_get_thread_num();id<threads;id+=omp_get_num_threads()) {
+					this->quiescent(Pooler::threadid_t(id));
+					callback(Pooler::threadid_t(id), newParam);
+					this->offline(Pooler::threadid_t(id));
+				}
+			}
+		}
+#endif
+
+		/* @brief The action that threads in the pool perform until a joinall/STOP command. 
+		 * @description 	Waits for RUN commands, performs action, then signals complete
+		 * @param[in] threadID	ID of this thread. Thread #1 is index 0
+		 */
+		void threadAction(Pooler::threadid_t threadID) {
+			// Threads will loop forever, waiting for instructions from the main thread
+			while (true) {
+				// -- CRITICAL SECTION -- 
+				{
+					// We will be waiting for commands
+					std::unique_lock<std::mutex> lock(this->_actionLock);
+					
+					{
+						std::lock_guard<std::mutex> waitLock(this->_waitLock);
+						this->_threadsWaiting++;
+					}
+					this->_waitCv.notify_all();
+
+					
+					// Now wait for a command
+					this->_actionCv.wait(lock, [&]{return this->_action != WAIT;});
+
+					if (this->_action == STOP) {
+						break; // Stop the loop
+					} 
+				}
+
+				// Do Thread action, in the current epoch
+				this->quiescent(threadID);
+				this->_threadCallback(threadID, this->_threadParam);
+				this->offline(threadID);
+				
+				// Signal to the main thread that we have finished work. 
+				{
+					std::unique_lock<std::mutex> lock(this->_actionLock);
 
 					{
 						std::lock_guard<std::mutex> completeLock(this->_completeLock);
@@ -243,4 +1090,1082 @@ class Pooler {
 			}
 		}
 };
+
+/* @brief 	Divides by a value only known at runtime using a multiply and two shifts, in the style of libdivide.
+ * @description Numerators and divisors that fit in 32 bits take the fast path. Anything wider falls back to a hardware division. 
+ */
+class Pooler::Divider {
+	private:
+		Pooler::index_t _divisor;
+		Pooler::index_t _limit;
+		uint32_t _magic;
+		uint8_t _shift1;
+		uint8_t _shift2;
+
+	public:
+		/* @brief Precompute the magic number for a divisor
+		 * @param[in] divisor	The value to divide by. Must not be 0. 
+		 */
+		Divider(Pooler::index_t divisor = 1) : _divisor(divisor), _limit(0), _magic(0), _shift1(0), _shift2(0) {
+			if (divisor == 0 || divisor > UINT32_MAX) {
+				return; // Only a numerator of 0 takes the fast path, and it divides to 0 with a magic number of 0
+			}
+
+			// ceil(log2(divisor))
+			uint8_t log = 0;
+			while ((uint64_t(1) << log) < divisor) {
+				log++;
+			}
+
+			this->_magic = uint32_t((((uint64_t(1) << log) - divisor) << 32) / divisor + 1);
+			this->_shift1 = log < 1 ? log : 1;
+			this->_shift2 = log - this->_shift1;
+			this->_limit = UINT32_MAX;
+		}
+
+		/* @brief Get the divisor this object was built for
+		 */
+		Pooler::index_t divisor() const {
+			return this->_divisor;
+		}
+
+		/* @brief Divide a numerator by the divisor, rounding down
+		 * @param[in] n	The numerator
+		 * @return	n / divisor
+		 */
+		Pooler::index_t divide(Pooler::index_t n) const {
+			if (n > this->_limit) {
+				return n / this->_divisor;
+			}
+
+			const uint32_t x = uint32_t(n);
+			const uint32_t high = uint32_t((uint64_t(this->_magic) * x) >> 32);
+			return (high + ((x - high) >> this->_shift1)) >> this->_shift2;
+		}
+
+		/* @brief Get the remainder of dividing a numerator by the divisor
+		 * @param[in] n	The numerator
+		 * @return	n % divisor
+		 */
+		Pooler::index_t modulo(Pooler::index_t n) const {
+			return n - this->divide(n) * this->_divisor;
+		}
+};
+
+/* @brief 	Splits [first, first + count) into one contiguous block per thread.
+ * @description The first (count % threads) threads receive one extra item. Boundaries are computed once at construction, 
+ * @description so handing a thread its range costs a multiply and an add. 
+ */
+class Pooler::BlockPartition {
+	private:
+		Pooler::index_t _first;
+		Pooler::index_t _quotient;
+		Pooler::index_t _remainder;
+		Pooler::threadid_t _threads;
+		Pooler::Divider _largeBlock;
+		Pooler::Divider _smallBlock;
+
+	public:
+		/* @brief Construct a new block partition
+		 * @param[in] count	The number of items to split
+		 * @param[in] threads	The number of threads to split between. Usually the pool's threadCount()
+		 * @param[in] first	The first index of the range
+		 */
+		BlockPartition(Pooler::index_t count, Pooler::threadid_t threads, Pooler::index_t first = 0) : 
+			_first(first), _quotient(count / threads), _remainder(count % threads), _threads(threads), 
+			_largeBlock(_quotient + 1), _smallBlock(_quotient ? _quotient : 1) {}
+
+		Pooler::threadid_t threadCount() const {
+			return this->_threads;
+		}
+
+		/* @brief Get the block owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @return	A contiguous Pooler::Range
+		 */
+		Pooler::Range range(Pooler::threadid_t id) const {
+			const Pooler::index_t begin = this->_first + id * this->_quotient + (id < this->_remainder ? id : this->_remainder);
+			const Pooler::index_t size = this->_quotient + (id < this->_remainder ? 1 : 0);
+			return Pooler::Range{begin, begin + size, size, size};
+		}
+
+		/* @brief Find the thread that owns an index
+		 * @param[in] i	An index within the partitioned range
+		 * @return	The id of the thread whose block contains i
+		 */
+		Pooler::threadid_t owner(Pooler::index_t i) const {
+			i -= this->_first;
+			const Pooler::index_t split = this->_remainder * (this->_quotient + 1);
+
+			if (i < split) {
+				return Pooler::threadid_t(this->_largeBlock.divide(i));
+			}
+			return Pooler::threadid_t(this->_remainder + this->_smallBlock.divide(i - split));
+		}
+};
+
+/* @brief 	Deals [first, first + count) out to the threads one index at a time, so thread 'id' owns id, id + threads, id + 2*threads...
+ */
+class Pooler::CyclicPartition {
+	private:
+		Pooler::index_t _first;
+		Pooler::index_t _count;
+		Pooler::Divider _threads;
+
+	public:
+		/* @brief Construct a new cyclic partition
+		 * @param[in] count	The number of items to split
+		 * @param[in] threads	The number of threads to split between. Usually the pool's threadCount()
+		 * @param[in] first	The first index of the range
+		 */
+		CyclicPartition(Pooler::index_t count, Pooler::threadid_t threads, Pooler::index_t first = 0) : 
+			_first(first), _count(count), _threads(threads) {}
+
+		Pooler::threadid_t threadCount() const {
+			return Pooler::threadid_t(this->_threads.divisor());
+		}
+
+		/* @brief Get the indices owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @return	A Pooler::Range with a block size of 1
+		 */
+		Pooler::Range range(Pooler::threadid_t id) const {
+			return Pooler::Range{this->_first + id, this->_first + this->_count, 1, this->_threads.divisor()};
+		}
+
+		/* @brief Find the thread that owns an index
+		 * @param[in] i	An index within the partitioned range
+		 * @return	(i - first) % threads
+		 */
+		Pooler::threadid_t owner(Pooler::index_t i) const {
+			return Pooler::threadid_t(this->_threads.modulo(i - this->_first));
+		}
+};
+
+/* @brief 	Cuts [first, first + count) into blocks of a fixed size and deals the blocks out to the threads in turn
+ */
+class Pooler::BlockCyclicPartition {
+	private:
+		Pooler::index_t _first;
+		Pooler::index_t _count;
+		Pooler::Divider _blockSize;
+		Pooler::Divider _threads;
+
+	public:
+		/* @brief Construct a new block-cyclic partition
+		 * @param[in] count	The number of items to split
+		 * @param[in] threads	The number of threads to split between. Usually the pool's threadCount()
+		 * @param[in] blockSize	The number of consecutive indices in each block
+		 * @param[in] first	The first index of the range
+		 */
+		BlockCyclicPartition(Pooler::index_t count, Pooler::threadid_t threads, Pooler::index_t blockSize, Pooler::index_t first = 0) : 
+			_first(first), _count(count), _blockSize(blockSize), _threads(threads) {}
+
+		Pooler::threadid_t threadCount() const {
+			return Pooler::threadid_t(this->_threads.divisor());
+		}
+
+		/* @brief Get the blocks owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @return	A Pooler::Range whose runs are the thread's blocks
+		 */
+		Pooler::Range range(Pooler::threadid_t id) const {
+			const Pooler::index_t block = this->_blockSize.divisor();
+			return Pooler::Range{this->_first + id * block, this->_first + this->_count, block, block * this->_threads.divisor()};
+		}
+
+		/* @brief Find the thread that owns an index
+		 * @param[in] i	An index within the partitioned range
+		 * @return	The id of the thread the index's block was dealt to
+		 */
+		Pooler::threadid_t owner(Pooler::index_t i) const {
+			return Pooler::threadid_t(this->_threads.modulo(this->_blockSize.divide(i - this->_first)));
+		}
+};
+
+/* @brief 	A block partition of [0, COUNT) between THREADS threads, computed entirely at compile time
+ */
+template<Pooler::index_t COUNT, Pooler::threadid_t THREADS>
+struct Pooler::StaticBlockPartition {
+	static_assert(THREADS > 0, "A partition needs at least one thread");
+
+	static constexpr Pooler::threadid_t threadCount() {
+		return THREADS;
+	}
+
+	/* @brief Get the first index owned by a thread
+	 */
+	static constexpr Pooler::index_t begin(Pooler::index_t id) {
+		return id * (COUNT / THREADS) + (id < COUNT % THREADS ? id : COUNT % THREADS);
+	}
+
+	/* @brief Get one past the last index owned by a thread
+	 */
+	static constexpr Pooler::index_t end(Pooler::index_t id) {
+		return begin(id + 1);
+	}
+
+	/* @brief Get the block owned by a thread
+	 * @return	A contiguous Pooler::Range
+	 */
+	static constexpr Pooler::Range range(Pooler::threadid_t id) {
+		return Pooler::Range{begin(id), end(id), end(id) - begin(id), end(id) - begin(id)};
+	}
+
+	/* @brief Find the thread that owns an index
+	 */
+	static constexpr Pooler::threadid_t owner(Pooler::index_t i) {
+		return Pooler::threadid_t(i < (COUNT % THREADS) * (COUNT / THREADS + 1) ? 
+			i / (COUNT / THREADS + 1) : 
+			COUNT % THREADS + (i - (COUNT % THREADS) * (COUNT / THREADS + 1)) / (COUNT / THREADS ? COUNT / THREADS : 1));
+	}
+};
+
+/* @brief 	Splits [first, first + count) into one contiguous block per thread, so that every block carries about the same total cost. 
+ * @description Costs are given as prefix sums: count + 1 values where item i costs prefix[i + 1] - prefix[i], such as the row pointers of a CSR matrix. 
+ * @description Each thread finds its own boundaries with two binary searches when it asks for its range, so the search runs in parallel. 
+ * @param[in] Cost	The arithmetic type of the prefix sums
+ */
+template<class Cost>
+class Pooler::WeightedPartition {
+	private:
+		const Cost* _prefix;
+		std::vector<Cost> _owned;
+		Pooler::index_t _first;
+		Pooler::index_t _count;
+		Pooler::threadid_t _threads;
+
+		const Cost* prefix() const {
+			return this->_owned.empty() ? this->_prefix : this->_owned.data();
+		}
+
+		/* @brief Find where a thread's block starts, relative to first
+		 * @param[in] id	The id of the thread. Passing the thread count gives the end of the range
+		 */
+		Pooler::index_t boundary(Pooler::index_t id) const {
+			const Cost* prefix = this->prefix();
+			const Cost total = prefix[this->_count] - prefix[0];
+
+			if (id >= this->_threads) {
+				return this->_count;
+			}
+
+			// Nothing to weigh by, so split evenly
+			if (!(total > Cost(0))) {
+				return Pooler::BlockPartition(this->_count, this->_threads).range(Pooler::threadid_t(id)).begin;
+			}
+
+			const Cost target = prefix[0] + Cost(double(total) * double(id) / double(this->_threads));
+			return Pooler::index_t(std::lower_bound(prefix, prefix + this->_count + 1, target) - prefix);
+		}
+
+	public:
+		/* @brief Construct a new weighted partition over existing prefix sums. The array must outlive the partition. 
+		 * @param[in] prefix	count + 1 non-decreasing prefix sums of the item costs
+		 * @param[in] count	The number of items to split
+		 * @param[in] threads	The number of threads to split between. Usually the pool's threadCount()
+		 * @param[in] first	The first index of the range
+		 */
+		WeightedPartition(const Cost* prefix, Pooler::index_t count, Pooler::threadid_t threads, Pooler::index_t first = 0) : 
+			_prefix(prefix), _first(first), _count(count), _threads(threads) {}
+
+		/* @brief Construct a new weighted partition from a cost function, computing the prefix sums on the pool
+		 * @param[in] pool	The pool the partition will be used with
+		 * @param[in] count	The number of items to split
+		 * @param[in] cost	A callable returning the cost of item i as a Cost, for i in [0, count). Called once per item
+		 * @param[in] first	The first index of the range
+		 */
+		template<class F>
+		WeightedPartition(Pooler& pool, Pooler::index_t count, F cost, Pooler::index_t first = 0) : 
+			_prefix(nullptr), _owned(count + 1), _first(first), _count(count), _threads(pool.threadCount()) {
+			std::vector<Cost> blockTotals(this->_threads + 1, Cost(0));
+			const Pooler::BlockPartition blocks(count, this->_threads);
+			Cost* prefix = this->_owned.data();
+
+			// Sum each block, scan the block totals, then write each block's prefix sums from its offset
+			pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+				Cost sum = Cost(0);
+				for (Pooler::index_t i=range.begin;i<range.end;i++) {
+					sum += prefix[i + 1] = cost(i);
+				}
+				blockTotals[id + 1] = sum;
+			});
+
+			for (Pooler::threadid_t id=0;id<this->_threads;id++) {
+				blockTotals[id + 1] += blockTotals[id];
+			}
+
+			pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+				Cost sum = blockTotals[id];
+				for (Pooler::index_t i=range.begin;i<range.end;i++) {
+					prefix[i + 1] = sum += prefix[i + 1];
+				}
+			});
+		}
+
+		Pooler::threadid_t threadCount() const {
+			return this->_threads;
+		}
+
+		/* @brief Get the block owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @return	A contiguous Pooler::Range
+		 */
+		Pooler::Range range(Pooler::threadid_t id) const {
+			const Pooler::index_t begin = this->boundary(id);
+			const Pooler::index_t end = std::max(begin, this->boundary(Pooler::index_t(id) + 1));
+			return Pooler::Range{this->_first + begin, this->_first + end, end - begin, end - begin};
+		}
+
+		/* @brief Find the thread that owns an index
+		 * @param[in] i	An index within the partitioned range
+		 * @return	The id of the thread whose block contains i
+		 */
+		Pooler::threadid_t owner(Pooler::index_t i) const {
+			i -= this->_first;
+
+			// The last thread whose block starts at or before i. Empty blocks share their start with the next one
+			Pooler::index_t low = 0;
+			Pooler::index_t high = this->_threads;
+			while (high - low > 1) {
+				const Pooler::index_t middle = low + (high - low) / 2;
+				if (this->boundary(middle) <= i) {
+					low = middle;
+				} else {
+					high = middle;
+				}
+			}
+			return Pooler::threadid_t(low);
+		}
+};
+
+/* @brief 	Read-mostly data shared with a pool's callbacks, replaced as a whole by publishing a new copy
+ * @description Callbacks read the current copy without locking. Publishing swaps in a new copy and retires the old one to the pool, 
+ * @description which deletes it once no callback can still be reading it. A pointer from read() stays valid until the callback returns 
+ * @description or the thread calls quiescent(). Outside callbacks, only the threads that publish may read. 
+ * @param[in] T	The type of the data
+ */
+template<class T>
+class Pooler::Rcu {
+	private:
+		Pooler& _pool;
+		std::atomic<T*> _current;
+
+	public:
+		/* @brief Construct a new published value
+		 * @param[in] pool	The pool whose callbacks read the value
+		 * @param[in] initial	The first copy, created with new. The Rcu takes ownership of it. May be nullptr
+		 */
+		Rcu(Pooler& pool, T* initial = nullptr) : _pool(pool), _current(initial) {}
+
+		Rcu(const Rcu&) = delete;
+		Rcu& operator=(const Rcu&) = delete;
+
+		/* @brief Delete the current copy. Nothing may be reading it
+		 */
+		~Rcu() {
+			delete this->_current.load();
+		}
+
+		/* @brief Get the current copy
+		 * @return	The current copy, or nullptr if nothing has been published
+		 */
+		const T* read() const {
+			return this->_current.load();
+		}
+
+		/* @brief Replace the current copy, retiring the old one to the pool
+		 * @param[in] next	The new copy, created with new. The Rcu takes ownership of it
+		 */
+		void publish(T* next) {
+			this->_pool.retire(this->_current.exchange(next));
+		}
+
+		/* @brief Replace the current copy with a copy of a value, retiring the old one to the pool
+		 * @param[in] value	The value to publish
+		 */
+		void publish(const T& value) {
+			this->publish(new T(value));
+		}
+};
+
+/* @brief 	One value per thread of a pool, for accumulating without locks or false sharing
+ * @description A thread's value is constructed the first time the thread asks for it, on that thread, so its memory is allocated 
+ * @description by the thread that uses it and is local to it on NUMA systems with first-touch allocation. Each value starts on a 
+ * @description cache line of its own and is rounded up to whole lines. Callbacks reach their value through their thread id; once the run is over, the values can be 
+ * @description combined or visited: 
+ * @description @code
+ * @description 	Pooler::local<double> sums(pool);
+ * @description 	pool.parallel_for(0, n, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+ * @description 		for (Pooler::index_t i=range.begin;i<range.end;i++) sums[id] += x[i];
+ * @description 	});
+ * @description 	const double sum = sums.combine(std::plus<double>());
+ * @description @endcode
+ * @param[in] T	The type of the values. Must be copy-constructible
+ */
+template<class T>
+class Pooler::local {
+	private:
+		// Starts on a cache line and fills whole ones, so no two threads' values share a line
+		struct alignas(64) Aligned {
+			T value;
+
+			Aligned(const T& initial) : value(initial) {}
+		};
+
+		// new only honours over-alignment from C++17, so the storage is aligned by hand and the raw allocation kept to free it
+		struct Slot {
+			Aligned* aligned;
+			void* raw;
+		};
+
+		T _initial;
+		std::vector<Slot> _values;
+
+	public:
+		/* @brief Construct a new set of per-thread values, all starting as copies of an initial value
+		 * @param[in] pool	The pool whose threads use the values, a Pooler or a FixedPooler<N>
+		 * @param[in] initial	The value each thread starts from
+		 */
+		template<class Pool>
+		explicit local(const Pool& pool, const T& initial = T()) : _initial(initial), _values(pool.threadCount(), Slot{nullptr, nullptr}) {}
+
+		local(const local&) = delete;
+		local& operator=(const local&) = delete;
+
+		~local() {
+			this->clear();
+		}
+
+		/* @brief Get a thread's value, constructing it on first use. Only the thread with this id may call this during a run
+		 * @param[in] id	The id of the calling thread
+		 */
+		T& operator[](Pooler::threadid_t id) {
+			Slot& slot = this->_values[id];
+			if (slot.aligned == nullptr) {
+				void* raw = ::operator new(sizeof(Aligned) + alignof(Aligned) - 1);
+				void* storage = reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(raw) + alignof(Aligned) - 1) & ~uintptr_t(alignof(Aligned) - 1));
+				try {
+					slot.aligned = new (storage) Aligned(this->_initial);
+				} catch (...) {
+					::operator delete(raw);
+					throw;
+				}
+				slot.raw = raw;
+			}
+			return slot.aligned->value;
+		}
+
+		/* @brief Check whether a thread has used its value
+		 */
+		bool has(Pooler::threadid_t id) const {
+			return this->_values[id].aligned != nullptr;
+		}
+
+		/* @brief Combine every constructed value in thread order
+		 * @param[in] op	A callable taking two values and returning their combination
+		 * @return	The combination, or the initial value if no thread used its value
+		 */
+		template<class Op>
+		T combine(Op op) const {
+			bool found = false;
+			T result = this->_initial;
+			for (const Slot& slot : this->_values) {
+				if (slot.aligned == nullptr) {
+					continue;
+				}
+
+				result = found ? op(result, slot.aligned->value) : slot.aligned->value;
+				found = true;
+			}
+			return result;
+		}
+
+		/* @brief Call a function with every constructed value, in thread order
+		 * @param[in] f	A callable taking a T&
+		 */
+		template<class F>
+		void each(F f) {
+			for (Slot& slot : this->_values) {
+				if (slot.aligned != nullptr) {
+					f(slot.aligned->value);
+				}
+			}
+		}
+
+		/* @brief Destroy every value, so the next use starts again from the initial value. No thread may be using them
+		 */
+		void clear() {
+			for (Slot& slot : this->_values) {
+				if (slot.aligned != nullptr) {
+					slot.aligned->~Aligned();
+					::operator delete(slot.raw);
+					slot = Slot{nullptr, nullptr};
+				}
+			}
+		}
+};
+
+inline void Pooler::parallel_for(Pooler::index_t begin, Pooler::index_t end, Pooler::range_func_t callback, void* newParam, Pooler::Schedule schedule, Pooler::index_t grain) {
+	const Pooler::index_t count = end > begin ? end - begin : 0;
+
+	if (schedule == STATIC) {
+		this->run(Pooler::BlockPartition(count, this->_THREAD_COUNT, begin), callback, newParam);
+		return;
+	}
+
+	if (grain == 0) {
+		grain = count / (Pooler::index_t(this->_THREAD_COUNT) * 16);
+	}
+	grain = std::max<Pooler::index_t>(1, std::min<Pooler::index_t>(grain, UINT32_MAX));
+
+	// Bounds are packed into 32 bits each, so longer loops are balanced one window at a time
+	for (Pooler::index_t window=begin;window<end;) {
+		const Pooler::index_t size = std::min<Pooler::index_t>(end - window, UINT32_MAX);
+		this->runAdaptive(window, uint32_t(size), callback, newParam, uint32_t(grain), this->_THREAD_COUNT);
+		window += size;
+	}
+}
+
+inline void Pooler::parallel_for(const Pooler::Site& site, Pooler::index_t begin, Pooler::index_t end, Pooler::range_func_t callback, void* newParam) {
+	const Pooler::index_t count = end > begin ? end - begin : 0;
+	if (count == 0) {
+		return;
+	}
+
+	Pooler::index_t grain;
+	Pooler::threadid_t active;
+	Pooler::Tuning* found;
+	{
+		std::lock_guard<std::mutex> lock(this->_tuningLock);
+		found = &this->tuningOf(site);
+		Pooler::Tuning& tuning = *found;
+
+		// Start from the default grain, rounded down to a power of two
+		if (tuning.grain == 0) {
+			const Pooler::index_t initial = std::max<Pooler::index_t>(1, count / (Pooler::index_t(this->_THREAD_COUNT) * 16));
+			for (tuning.grain=1;tuning.grain*2<=initial;tuning.grain*=2) {}
+		}
+
+		// Start a probe of thread counts from all threads down
+		if ((site.tune & TUNE_THREADS) && !tuning.probing && tuning.runsSinceProbe >= TUNING_REPROBE) {
+			tuning.probing = true;
+			tuning.threads = this->_THREAD_COUNT;
+			tuning.bestThreads = this->_THREAD_COUNT;
+			tuning.bestThreadCost = 0;
+			tuning.threadCost = 0;
+			tuning.threadSamples = 0;
+		}
+
+		grain = std::min(tuning.grain, count);
+		// A thread count learned or imported under the same tag only applies to sites that tune it
+		const bool tuneThreads = (site.tune & TUNE_THREADS) && tuning.threads != 0 && tuning.threads <= this->_THREAD_COUNT;
+		active = tuneThreads ? tuning.threads : this->_THREAD_COUNT;
+	}
+
+	std::vector<FinishTime> finished(active);
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (FinishTime& time : finished) {
+		time.at = start;
+	}
+
+	for (Pooler::index_t window=begin;window<end;) {
+		const Pooler::index_t size = std::min<Pooler::index_t>(end - window, UINT32_MAX);
+		this->runAdaptive(window, uint32_t(size), [&](Pooler::threadid_t id, const Pooler::Range& range, void* data) {
+			callback(id, range, data);
+			finished[id].at = std::chrono::steady_clock::now();
+		}, newParam, uint32_t(std::min<Pooler::index_t>(grain, UINT32_MAX)), active);
+		window += size;
+	}
+
+	// Idle time is how long each thread waited between its last chunk and the end of the loop
+	const std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+	const double wall = std::chrono::duration<double, std::nano>(stop - start).count();
+	double idle = 0;
+	for (const FinishTime& time : finished) {
+		idle += std::chrono::duration<double, std::nano>(stop - time.at).count();
+	}
+
+	std::lock_guard<std::mutex> lock(this->_tuningLock);
+	Pooler::Tuning& tuning = *found;
+
+	if ((site.tune & TUNE_THREADS) && tuning.probing) {
+		this->tuneThreads(tuning, wall / double(count));
+	} else {
+		tuning.runsSinceProbe++;
+		if (site.tune & TUNE_GRAIN) {
+			this->tuneGrain(tuning, count, wall / double(count), wall > 0 ? idle / (wall * active) : 0);
+		}
+	}
+}
+
+/* @brief Find a call site's tuning, adding it on first use. The tuning lock must be held
+ * @description A const char* tag is looked up by its text once, then by its address. The std::map never moves its nodes, so the cached pointer stays valid
+ */
+inline Pooler::Tuning& Pooler::tuningOf(const Pooler::Site& site) {
+	if (site.literal == nullptr) {
+		return this->_tuning[site.tag];
+	}
+
+	Pooler::Tuning*& cached = this->_tuningSites[site.literal];
+	if (cached == nullptr) {
+		cached = &this->_tuning[std::string(site.literal)];
+	}
+	return *cached;
+}
+
+/* @brief Record one measurement of a thread count probe, and move on to fewer threads once enough samples have been averaged
+ * @description Candidates go from all threads down in steps of an eighth. Ties within 2% go to the smaller count, which frees threads for 
+ * @description other work, and the probe stops early once a candidate is 15% slower than the best, since fewer threads won't recover. 
+ * @param[in] tuning	The site's tuning state
+ * @param[in] cost	Nanoseconds per index
+ */
+inline void Pooler::tuneThreads(Pooler::Tuning& tuning, double cost) {
+	tuning.threadCost += cost;
+	if (++tuning.threadSamples < TUNING_SAMPLES) {
+		return;
+	}
+
+	const double average = tuning.threadCost / tuning.threadSamples;
+	tuning.threadCost = 0;
+	tuning.threadSamples = 0;
+
+	bool finished = false;
+	if (tuning.bestThreadCost == 0 || average <= tuning.bestThreadCost * 1.02) {
+		tuning.bestThreads = tuning.threads;
+		tuning.bestThreadCost = tuning.bestThreadCost == 0 ? average : std::min(tuning.bestThreadCost, average);
+	} else if (average > tuning.bestThreadCost * 1.15) {
+		finished = true;
+	}
+
+	// The next candidate is the largest multiple of an eighth of the pool below the current count
+	Pooler::threadid_t next = tuning.threads;
+	for (Pooler::index_t eighth=7;eighth>0;eighth--) {
+		const Pooler::threadid_t candidate = Pooler::threadid_t(this->_THREAD_COUNT * eighth / 8);
+		if (candidate > 0 && candidate < tuning.threads) {
+			next = candidate;
+			break;
+		}
+	}
+
+	if (finished || next >= tuning.threads) {
+		tuning.probing = false;
+		tuning.threads = tuning.bestThreads;
+		tuning.runsSinceProbe = 0;
+		return;
+	}
+	tuning.threads = next;
+}
+
+/* @brief Record one measurement of a tuned loop, and take a step once enough samples of the current grain have been averaged
+ * @param[in] tuning	The site's tuning state
+ * @param[in] count	The number of indices in the loop
+ * @param[in] cost	Nanoseconds per index
+ * @param[in] idle	The fraction of the loop's thread time spent idle at the end
+ */
+inline void Pooler::tuneGrain(Pooler::Tuning& tuning, Pooler::index_t count, double cost, double idle) {
+	if (tuning.direction == 0) {
+		return;
+	}
+
+	tuning.cost += cost;
+	if (++tuning.samples < TUNING_SAMPLES) {
+		return;
+	}
+
+	const double average = tuning.cost / tuning.samples;
+	tuning.cost = 0;
+	tuning.samples = 0;
+
+	if (tuning.bestCost == 0) {
+		// First measurement. Imbalance calls for smaller chunks, otherwise chunk overhead calls for larger ones
+		tuning.bestGrain = tuning.grain;
+		tuning.bestCost = average;
+		tuning.direction = idle > 0.1 ? -1 : 1;
+	} else if (average < tuning.bestCost * 0.97) {
+		tuning.bestGrain = tuning.grain;
+		tuning.bestCost = average;
+	} else if (!tuning.reversed) {
+		// Stepping this way made things worse, so try the other side of the best grain
+		tuning.reversed = true;
+		tuning.direction = -tuning.direction;
+		tuning.grain = tuning.bestGrain;
+	} else {
+		tuning.direction = 0;
+		tuning.grain = tuning.bestGrain;
+		return;
+	}
+
+	const Pooler::index_t next = tuning.direction > 0 ? tuning.grain * 2 : tuning.grain / 2;
+	if (next == 0 || next > count) {
+		if (tuning.reversed) {
+			tuning.direction = 0;
+			tuning.grain = tuning.bestGrain;
+			return;
+		}
+		tuning.reversed = true;
+		tuning.direction = -tuning.direction;
+		tuning.grain = tuning.direction > 0 ? tuning.bestGrain * 2 : tuning.bestGrain / 2;
+		if (tuning.grain == 0 || tuning.grain > count) {
+			tuning.direction = 0;
+			tuning.grain = tuning.bestGrain;
+		}
+		return;
+	}
+	tuning.grain = next;
+}
+
+inline std::string Pooler::exportTuning() {
+	std::lock_guard<std::mutex> lock(this->_tuningLock);
+	std::ostringstream out;
+
+	for (const std::pair<const std::string, Pooler::Tuning>& site : this->_tuning) {
+		const Pooler::Tuning& tuning = site.second;
+		out << site.first << "\tgrain=" << (tuning.direction == 0 || tuning.bestGrain == 0 ? tuning.grain : tuning.bestGrain);
+		if (tuning.bestThreads != 0) {
+			out << "\tthreads=" << tuning.bestThreads;
+		}
+		out << "\n";
+	}
+	return out.str();
+}
+
+inline void Pooler::importTuning(const std::string& tuning) {
+	std::lock_guard<std::mutex> lock(this->_tuningLock);
+	std::istringstream in(tuning);
+	std::string line;
+
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::string tag;
+		std::string setting;
+
+		if (!std::getline(fields, tag, '\t') || tag.empty()) {
+			continue;
+		}
+
+		while (std::getline(fields, setting, '\t')) {
+			const std::string::size_type equals = setting.find('=');
+			if (equals == std::string::npos) {
+				continue;
+			}
+
+			const std::string key = setting.substr(0, equals);
+			std::istringstream number(setting.substr(equals + 1));
+			Pooler::index_t value = 0;
+			if (!(number >> value) || value == 0) {
+				continue;
+			}
+
+			if (key == "grain") {
+				Pooler::Tuning& site = this->_tuning[tag];
+				site.grain = value;
+				site.bestGrain = value;
+				site.direction = 0;
+			} else if (key == "threads" && value <= this->_THREAD_COUNT) {
+				// Still re-probed every TUNING_REPROBE runs, in case this machine differs from the one that exported it
+				Pooler::Tuning& site = this->_tuning[tag];
+				site.threads = Pooler::threadid_t(value);
+				site.bestThreads = Pooler::threadid_t(value);
+				site.runsSinceProbe = 0;
+			}
+		}
+	}
+}
+
+/* @brief Run one window of an ADAPTIVE loop, using lazy binary splitting
+ * @description Each thread takes 'grain' indices at a time from the front of its own range. Once its range is empty, it steals the back half of 
+ * @description the largest range left and carries on with that, so the loop finishes close to total work / N even if a thread falls behind. 
+ * @param[in] first	The index the window starts at
+ * @param[in] count	The number of indices in the window
+ * @param[in] callback	The callback function as defined in some POOLER_RANGE_FUNC
+ * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+ * @param[in] grain	The number of indices a thread takes from its own range at a time
+ * @param[in] active	The number of threads taking part. Threads with higher ids return straight away and stay parked, unusable by other runs, until this run ends
+ */
+inline void Pooler::runAdaptive(Pooler::index_t first, uint32_t count, const Pooler::range_func_t& callback, void* newParam, uint32_t grain, Pooler::threadid_t active) {
+	std::vector<StealSlot> slots(active);
+	const Pooler::BlockPartition partition(count, active);
+
+	for (Pooler::threadid_t id=0;id<active;id++) {
+		const Pooler::Range range = partition.range(id);
+		slots[id].bounds = (uint64_t(range.begin) << 32) | uint64_t(range.end);
+	}
+
+	this->run([&](Pooler::threadid_t id, void* data) {
+		if (id >= active) {
+			return;
+		}
+		std::atomic<uint64_t>& own = slots[id].bounds;
+
+		while (true) {
+			// Take chunks from the front of our own range
+			uint64_t bounds = own.load();
+			while (uint32_t(bounds >> 32) < uint32_t(bounds)) {
+				this->yieldToOpenMP();
+
+				const uint32_t begin = uint32_t(bounds >> 32);
+				const uint32_t end = begin + std::min(grain, uint32_t(bounds) - begin);
+
+				if (own.compare_exchange_weak(bounds, (uint64_t(end) << 32) | uint32_t(bounds))) {
+					callback(id, Pooler::Range{first + begin, first + end, end - begin, end - begin}, data);
+					bounds = own.load();
+				}
+			}
+
+			// Out of work. Steal the back half of the largest range left, or stop if every range is empty
+			bool stole = false;
+			while (!stole) {
+				Pooler::threadid_t victim = id;
+				uint64_t victimBounds = 0;
+				uint32_t largest = 0;
+
+				for (Pooler::threadid_t other=0;other<active;other++) {
+					const uint64_t otherBounds = slots[other].bounds.load();
+					const uint32_t begin = uint32_t(otherBounds >> 32);
+					const uint32_t end = uint32_t(otherBounds);
+
+					if (begin < end && end - begin > largest) {
+						victim = other;
+						victimBounds = otherBounds;
+						largest = end - begin;
+					}
+				}
+
+				if (largest == 0) {
+					return;
+				}
+
+				// A single index left is taken whole
+				const uint32_t begin = uint32_t(victimBounds >> 32);
+				const uint32_t middle = begin + largest / 2;
+				if (slots[victim].bounds.compare_exchange_strong(victimBounds, (uint64_t(begin) << 32) | middle)) {
+					// Nobody else writes to an empty slot, so the stolen range can be published with a plain store
+					own.store((uint64_t(middle) << 32) | uint32_t(victimBounds));
+					stole = true;
+				}
+			}
+		}
+	}, newParam);
+}
+
+/* @brief 	A thread pool whose thread count is known at compile time.
+ * @description Behaves like Pooler, but per-worker state is held in std::arrays, the completion barrier counts down from the constant N, 
+ * @description and the block partitioning math divides by a constant, which lets the compiler replace the division with a multiplication.
+ * @param[in] N	The number of threads this thread pool instance will use
+ */
+template<Pooler::threadid_t N>
+class FixedPooler {
+	static_assert(N > 0, "A FixedPooler needs at least one thread");
+
+	// Typedefs 
+	public:
+		typedef Pooler::threadid_t threadid_t;
+		typedef Pooler::index_t index_t;
+		typedef Pooler::func_t func_t;
+
+		static constexpr threadid_t THREAD_COUNT = N;
+
+	// Private vars
+	private:
+		// Store threads
+		std::array<std::thread, N> _threads;
+
+		// Set when the threads must be started again before the next run(), such as in the child of a fork()
+		bool _respawn;
+
+		// Synchronization. Each run bumps the generation, and the barrier counts down from N. 
+		uint32_t _generation;
+		bool _stopping;
+		std::mutex _runLock;
+		std::atomic<threadid_t> _threadsRemaining;
+		std::mutex _actionLock;
+		std::mutex _completeLock;
+		std::condition_variable _actionCv;
+		std::condition_variable _completeCv;
+
+		// A callback performed by each thread
+		func_t _threadCallback;
+		// A pointer to some data structure 
+		void* _threadParam;
+
+		/* @brief Start every thread of the pool. Threads wait for the generation after the current one
+		 */
+		void startThreads() {
+			for (threadid_t id=0;id<N;id++) {
+				this->_threads[id] = std::thread(&FixedPooler::threadAction, this, id, this->_generation);
+			}
+			this->_respawn = false;
+		}
+
+	public:
+		/* @brief Construct a new fixed pooler object and start all N threads
+		 */
+		FixedPooler() : _respawn(false), _generation(0), _stopping(false), _threadsRemaining(0), _threadParam(nullptr) {
+			this->startThreads();
+
+#ifdef __POOLER_ATFORK
+			PoolerForkRegistry::add(this, [](void* pool) {static_cast<FixedPooler*>(pool)->prepareFork();}, 
+				[](void* pool) {static_cast<FixedPooler*>(pool)->parentAfterFork();}, [](void* pool) {static_cast<FixedPooler*>(pool)->childAfterFork();});
+#endif
+		}
+
+		~FixedPooler() {
+#ifdef __POOLER_ATFORK
+			PoolerForkRegistry::remove(this);
+#endif
+		}
+
+		/* @brief Get the number of threads in this pool
+		 * @return	N
+		 */
+		static constexpr threadid_t threadCount() {
+			return N;
+		}
+
+		/* @brief Get the first index of the block of [0, count) owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @param[in] count	The number of items being split between the N threads
+		 * @return	The first index owned by thread 'id'. The first (count % N) threads receive one extra item. 
+		 */
+		static constexpr index_t blockBegin(index_t id, index_t count) {
+			return id * (count / N) + (id < count % N ? id : count % N);
+		}
+
+		/* @brief Get one past the last index of the block of [0, count) owned by a thread
+		 * @param[in] id	The id of the thread
+		 * @param[in] count	The number of items being split between the N threads
+		 * @return	The end of the block owned by thread 'id'
+		 */
+		static constexpr index_t blockEnd(index_t id, index_t count) {
+			return blockBegin(id + 1, count);
+		}
+
+		/* @brief Set the callback to perform in all threads, then signal each thread to perform the action. 
+		 * @param[in] callback	The callback function as defined in some POOLER_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. Thread-safe by default. 
+		 */
+		void run(func_t callback, void* newParam = nullptr) {
+			// Only one run at a time. This also lets a fork() wait for the pool to go quiet
+			std::lock_guard<std::mutex> runLock(this->_runLock);
+
+			// The child of a fork() starts its threads on the first run
+			if (this->_respawn) {
+				this->startThreads();
+			}
+
+			// Every thread has finished the previous generation by the time run() returns, so no thread can miss this one
+			{
+				std::lock_guard<std::mutex> lock(this->_actionLock);
+				this->_threadCallback = std::move(callback);
+				this->_threadParam = newParam;
+				this->_threadsRemaining = N;
+				this->_generation++;
+			}
+			this->_actionCv.notify_all();
+
+			// Wait for the last thread to count the barrier down to zero
+			std::unique_lock<std::mutex> completeLock(this->_completeLock);
+			this->_completeCv.wait(completeLock, [&]{return this->_threadsRemaining == 0;});
+		}
+
+		/* @brief Run a range callback in all threads, handing each thread the range a partition assigned to it
+		 * @param[in] partition	A partition built for N threads, such as a Pooler::StaticBlockPartition<COUNT, N>
+		 * @param[in] callback	The callback function as defined in some POOLER_RANGE_FUNC
+		 * @param[in] newParam	A pointer to some data-structure that will be passed to each thread. 
+		 */
+		template<class Partition>
+		auto run(const Partition& partition, Pooler::range_func_t callback, void* newParam = nullptr) -> decltype(partition.range(threadid_t()), void()) {
+			this->run([&](threadid_t id, void* data) {
+				callback(id, partition.range(id), data);
+			}, newParam);
+		}
+
+		/* @brief Tell the threads to perform a STOP command, then wait for all threads to terminate 
+		 */
+		void stop() {
+			std::lock_guard<std::mutex> runLock(this->_runLock);
+			this->_respawn = false;
+
+			{
+				std::lock_guard<std::mutex> lock(this->_actionLock);
+				this->_stopping = true;
+			}
+			this->_actionCv.notify_all();
+
+			for (threadid_t i=0;i<N;i++) {
+				if (this->_threads[i].joinable()) {
+					this->_threads[i].join();
+				}
+			}
+		}
+
+	private:
+#ifdef __POOLER_ATFORK
+		/* @brief Quiesce the pool before fork(): wait for any run() in progress, and hold the locks. 
+		 * @description Threads may still be counting down the barrier of the last run, which they do while holding the completeLock. 
+		 */
+		void prepareFork() {
+			this->_runLock.lock();
+			this->_actionLock.lock();
+			this->_completeLock.lock();
+		}
+
+		/* @brief Resume the pool in the parent once fork() returns
+		 */
+		void parentAfterFork() {
+			this->_completeLock.unlock();
+			this->_actionLock.unlock();
+			this->_runLock.unlock();
+		}
+
+		/* @brief Reset the pool in the child once fork() returns, abandoning the threads that no longer exist. Threads are started again by the next run(). 
+		 */
+		void childAfterFork() {
+			for (threadid_t id=0;id<N;id++) {
+				if (this->_threads[id].joinable()) {
+					new (&this->_threads[id]) std::thread();
+					this->_respawn = true;
+				}
+			}
+
+			new (&this->_runLock) std::mutex();
+			new (&this->_actionLock) std::mutex();
+			new (&this->_completeLock) std::mutex();
+			new (&this->_actionCv) std::condition_variable();
+			new (&this->_completeCv) std::condition_variable();
+		}
+#endif
+
+		/* @brief The action that threads in the pool perform until a STOP command. 
+		 * @description 	Waits for a new generation, performs action, then counts down the barrier
+		 * @param[in] threadID	ID of this thread. Thread #1 is index 0
+		 * @param[in] seen	The generation current when the thread was started
+		 */
+		void threadAction(threadid_t threadID, uint32_t seen) {
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(this->_actionLock);
+					this->_actionCv.wait(lock, [&]{return this->_generation != seen || this->_stopping;});
+
+					if (this->_stopping) {
+						break; // Stop the loop
+					}
+					seen = this->_generation;
+				}
+
+				// Do Thread action
+				this->_threadCallback(threadID, this->_threadParam);
+
+				// The last thread to finish wakes the main thread
+				if (--this->_threadsRemaining == 0) {
+					std::lock_guard<std::mutex> completeLock(this->_completeLock);
+					this->_completeCv.notify_all();
+				}
+			}
+		}
+};
+
+template<Pooler::threadid_t N>
+constexpr Pooler::threadid_t FixedPooler<N>::THREAD_COUNT;
 #endif
@@ -0,0 +1,734 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_ALGORITHM_H
+#define HONEYLIB_POOLER_ALGORITHM_H
+
+#include "pooler.h"
+
+#include <iterator>
+#include <utility>
+#include <unordered_map>
+#include <type_traits>
+
+/* Parallel algorithms built on top of a pool. 
+ * Every algorithm takes the pool to run on as its first argument, which may be a Pooler or a FixedPooler<N>, 
+ * and blocks until the result is ready. Iterators must be random-access. 
+ */
+namespace pooler {
+	namespace detail {
+		/* @brief Pick a chunk size for loops whose threads claim chunks one after another
+		 * @param[in] count	The number of items in the loop
+		 * @param[in] threads	The number of threads sharing the loop
+		 * @param[in] grain	The chunk size asked for by the caller, or 0 to pick one
+		 */
+		inline Pooler::index_t chunkSize(Pooler::index_t count, Pooler::threadid_t threads, Pooler::index_t grain) {
+			if (grain > 0) {
+				return grain;
+			}
+			return std::max<Pooler::index_t>(1, std::min<Pooler::index_t>(16384, count / (Pooler::index_t(threads) * 16)));
+		}
+
+		/* @brief Lower an atomic index to a value, if the value is smaller
+		 */
+		inline void atomicMin(std::atomic<Pooler::index_t>& target, Pooler::index_t value) {
+			Pooler::index_t current = target.load();
+			while (value < current && !target.compare_exchange_weak(current, value)) {}
+		}
+
+		/* @brief Label every element of a range with a class, and work out where each block's elements of each class go in a stable grouping
+		 * @description The first half of a count, scan, scatter pass. Each thread labels its block and counts its classes, 
+		 * @description then the counts are scanned so that class 0 comes first, then class 1, and so on, with blocks in order inside each class. 
+		 * @param[in] pool	The pool to run on
+		 * @param[in] first	The start of the range
+		 * @param[in] blocks	A block partition of the range for the pool's threads
+		 * @param[in] classes	The number of classes. At most 256
+		 * @param[in] classify	A callable taking an element and returning its class, from 0 to classes - 1. Called once per element
+		 * @param[out] labels	Set to the class of every element
+		 * @return	classes * threads + 1 offsets. Entry (c * threads + id) is where block id's class c elements start. The last entry is the count
+		 */
+		template<class Pool, class It, class Classify>
+		std::vector<Pooler::index_t> classifyBlocks(Pool& pool, It first, const Pooler::BlockPartition& blocks, unsigned classes, Classify classify, std::vector<uint8_t>& labels) {
+			const Pooler::threadid_t threads = blocks.threadCount();
+			std::vector<Pooler::index_t> offsets(classes * threads + 1, 0);
+
+			pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+				std::vector<Pooler::index_t> counts(classes, 0);
+				for (Pooler::index_t i=range.begin;i<range.end;i++) {
+					const uint8_t label = uint8_t(classify(first[i]));
+					labels[i] = label;
+					counts[label]++;
+				}
+
+				for (unsigned c=0;c<classes;c++) {
+					offsets[c * threads + id] = counts[c];
+				}
+			});
+
+			// Exclusive scan, class major and block minor
+			Pooler::index_t total = 0;
+			for (Pooler::index_t i=0;i<offsets.size();i++) {
+				const Pooler::index_t count = offsets[i];
+				offsets[i] = total;
+				total += count;
+			}
+			return offsets;
+		}
+
+		/* @brief Hand every element of a range its destination from classifyBlocks(), the second half of a count, scan, scatter pass
+		 * @param[in] pool	The pool to run on
+		 * @param[in] blocks	The block partition given to classifyBlocks()
+		 * @param[in] offsets	The offsets returned by classifyBlocks()
+		 * @param[in] labels	The labels set by classifyBlocks()
+		 * @param[in] scatter	A callable taking an element's index, its class and its destination. Called once per element, concurrently
+		 */
+		template<class Pool, class Scatter>
+		void scatterBlocks(Pool& pool, const Pooler::BlockPartition& blocks, const std::vector<Pooler::index_t>& offsets, const std::vector<uint8_t>& labels, Scatter scatter) {
+			const Pooler::threadid_t threads = blocks.threadCount();
+			const unsigned classes = unsigned((offsets.size() - 1) / threads);
+
+			pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+				std::vector<Pooler::index_t> next(classes);
+				for (unsigned c=0;c<classes;c++) {
+					next[c] = offsets[c * threads + id];
+				}
+
+				for (Pooler::index_t i=range.begin;i<range.end;i++) {
+					scatter(i, labels[i], next[labels[i]]++);
+				}
+			});
+		}
+
+		/* @brief Move the elements of a range into a temporary buffer, grouped stably by class, then move them back
+		 * @return	The offsets returned by classifyBlocks()
+		 */
+		template<class Pool, class It, class Classify>
+		std::vector<Pooler::index_t> stableGroup(Pool& pool, It first, It last, unsigned classes, Classify classify) {
+			typedef typename std::iterator_traits<It>::value_type value_type;
+
+			const Pooler::index_t count = Pooler::index_t(last - first);
+			const Pooler::BlockPartition blocks(count, pool.threadCount());
+			std::vector<uint8_t> labels(count);
+			const std::vector<Pooler::index_t> offsets = classifyBlocks(pool, first, blocks, classes, classify, labels);
+
+			std::vector<value_type> buffer(count);
+			scatterBlocks(pool, blocks, offsets, labels, [&](Pooler::index_t i, unsigned, Pooler::index_t destination) {
+				buffer[destination] = std::move(first[i]);
+			});
+
+			pool.run(blocks, [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+				std::move(buffer.begin() + range.begin, buffer.begin() + range.end, first + range.begin);
+			});
+			return offsets;
+		}
+
+		/* @brief Find where the element at a rank of a stable k-way merge comes from, and how much of each run precedes it
+		 * @description Elements are ordered by value, then by run, then by position, which is the order a stable merge produces. 
+		 * @description The element at the rank is searched for in each run in turn; its rank within the merge is monotone in its position. 
+		 * @param[in] runs	The begin and end of every sorted run
+		 * @param[in] rank	The output position to split at
+		 * @param[in] total	The total number of elements
+		 * @param[out] split	Set to the number of elements of each run that come before the rank
+		 */
+		template<class It, class Compare>
+		void coRank(const std::vector<std::pair<It, It>>& runs, Pooler::index_t rank, Pooler::index_t total, Compare comp, std::vector<Pooler::index_t>& split) {
+			const std::size_t k = runs.size();
+			split.assign(k, 0);
+			if (rank == 0) {
+				return;
+			}
+
+			if (rank >= total) {
+				for (std::size_t i=0;i<k;i++) {
+					split[i] = Pooler::index_t(runs[i].second - runs[i].first);
+				}
+				return;
+			}
+
+			// The rank of the element at a position of run j, in the stable merge order
+			auto rankOf = [&](std::size_t j, Pooler::index_t position) {
+				const auto& value = runs[j].first[position];
+				Pooler::index_t result = position;
+				for (std::size_t i=0;i<k;i++) {
+					if (i < j) {
+						result += Pooler::index_t(std::upper_bound(runs[i].first, runs[i].second, value, comp) - runs[i].first);
+					} else if (i > j) {
+						result += Pooler::index_t(std::lower_bound(runs[i].first, runs[i].second, value, comp) - runs[i].first);
+					}
+				}
+				return result;
+			};
+
+			for (std::size_t j=0;j<k;j++) {
+				Pooler::index_t low = 0;
+				Pooler::index_t high = Pooler::index_t(runs[j].second - runs[j].first);
+
+				// Find the first position of run j whose rank is at least the one we want
+				while (low < high) {
+					const Pooler::index_t middle = low + (high - low) / 2;
+					if (rankOf(j, middle) < rank) {
+						low = middle + 1;
+					} else {
+						high = middle;
+					}
+				}
+
+				if (low == Pooler::index_t(runs[j].second - runs[j].first) || rankOf(j, low) != rank) {
+					continue;
+				}
+
+				const auto& value = runs[j].first[low];
+				for (std::size_t i=0;i<k;i++) {
+					if (i < j) {
+						split[i] = Pooler::index_t(std::upper_bound(runs[i].first, runs[i].second, value, comp) - runs[i].first);
+					} else if (i > j) {
+						split[i] = Pooler::index_t(std::lower_bound(runs[i].first, runs[i].second, value, comp) - runs[i].first);
+					} else {
+						split[i] = low;
+					}
+				}
+				return;
+			}
+		}
+	}
+
+	/* @brief Find the first element of [first, last) that satisfies a predicate
+	 * @description Threads claim chunks in index order and publish the lowest match found so far. Chunks beyond it are abandoned, 
+	 * @description so the work done is proportional to the position of the first match rather than the length of the range. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] pred	A callable taking an element and returning bool. Called concurrently
+	 * @param[in] grain	The number of elements in each chunk, or 0 to pick one
+	 * @return	An iterator to the first match, or last if there is none
+	 */
+	template<class Pool, class It, class Pred>
+	It parallel_find_if(Pool& pool, It first, It last, Pred pred, Pooler::index_t grain = 0) {
+		const Pooler::index_t count = Pooler::index_t(last - first);
+		if (count == 0) {
+			return last;
+		}
+
+		const Pooler::index_t chunk = detail::chunkSize(count, pool.threadCount(), grain);
+		std::atomic<Pooler::index_t> next(0);
+		std::atomic<Pooler::index_t> found(count);
+
+		pool.run([&](Pooler::threadid_t, void*) {
+			while (true) {
+				const Pooler::index_t begin = next.fetch_add(chunk);
+
+				// Chunks are claimed in order, so every chunk after this one lies beyond the match too
+				if (begin >= count || begin >= found.load(std::memory_order_relaxed)) {
+					return;
+				}
+
+				const Pooler::index_t end = std::min(begin + chunk, count);
+				for (Pooler::index_t i=begin;i<end && i<found.load(std::memory_order_relaxed);i++) {
+					if (pred(first[i])) {
+						detail::atomicMin(found, i);
+						break;
+					}
+				}
+			}
+		});
+
+		return first + typename std::iterator_traits<It>::difference_type(found.load());
+	}
+
+	/* @brief Check whether any element of [first, last) satisfies a predicate, stopping at the first one found
+	 * @return	True if pred returned true for some element
+	 */
+	template<class Pool, class It, class Pred>
+	bool parallel_any_of(Pool& pool, It first, It last, Pred pred, Pooler::index_t grain = 0) {
+		return parallel_find_if(pool, first, last, pred, grain) != last;
+	}
+
+	/* @brief Check whether every element of [first, last) satisfies a predicate, stopping at the first one that doesn't
+	 * @return	True if pred returned true for every element, or the range is empty
+	 */
+	template<class Pool, class It, class Pred>
+	bool parallel_all_of(Pool& pool, It first, It last, Pred pred, Pooler::index_t grain = 0) {
+		typedef typename std::iterator_traits<It>::reference reference;
+		return parallel_find_if(pool, first, last, [&](reference value) {return !pred(value);}, grain) == last;
+	}
+
+	/* @brief Check that no element of [first, last) satisfies a predicate, stopping at the first one that does
+	 * @return	True if pred returned false for every element, or the range is empty
+	 */
+	template<class Pool, class It, class Pred>
+	bool parallel_none_of(Pool& pool, It first, It last, Pred pred, Pooler::index_t grain = 0) {
+		return !parallel_any_of(pool, first, last, pred, grain);
+	}
+
+	/* @brief Copy the elements of [first, last) that satisfy a predicate to out, keeping their order
+	 * @description Each thread counts the matches in its block, the counts are scanned into output offsets, and each thread then writes its 
+	 * @description matches straight into the destination. The predicate is evaluated once per element, and only a byte per element is kept in between. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] out	The start of the destination, which must have room for every match
+	 * @param[in] pred	A callable taking an element and returning bool. Called concurrently
+	 * @return	An iterator one past the last element written
+	 */
+	template<class Pool, class It, class OutIt, class Pred>
+	OutIt parallel_copy_if(Pool& pool, It first, It last, OutIt out, Pred pred) {
+		const Pooler::index_t count = Pooler::index_t(last - first);
+		const Pooler::BlockPartition blocks(count, pool.threadCount());
+		std::vector<uint8_t> labels(count);
+
+		typedef typename std::iterator_traits<It>::reference reference;
+		const std::vector<Pooler::index_t> offsets = detail::classifyBlocks(pool, first, blocks, 2, [&](reference value) {return pred(value) ? 0 : 1;}, labels);
+
+		detail::scatterBlocks(pool, blocks, offsets, labels, [&](Pooler::index_t i, unsigned label, Pooler::index_t destination) {
+			if (label == 0) {
+				out[destination] = first[i];
+			}
+		});
+
+		return out + offsets[blocks.threadCount()];
+	}
+
+	/* @brief Reorder [first, last) so the elements that satisfy a predicate come first, keeping the relative order within both groups
+	 * @description Elements are moved through a temporary buffer, so the value type must be default-constructible and move-assignable. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] pred	A callable taking an element and returning bool. Called once per element, concurrently
+	 * @return	An iterator to the first element of the second group
+	 */
+	template<class Pool, class It, class Pred>
+	It parallel_stable_partition(Pool& pool, It first, It last, Pred pred) {
+		typedef typename std::iterator_traits<It>::reference reference;
+		const std::vector<Pooler::index_t> offsets = detail::stableGroup(pool, first, last, 2, [&](reference value) {return pred(value) ? 0 : 1;});
+		return first + typename std::iterator_traits<It>::difference_type(offsets[pool.threadCount()]);
+	}
+
+	/* @brief Remove the elements of [first, last) that satisfy a predicate, keeping the order of the others
+	 * @description Elements are moved through a temporary buffer, so the value type must be default-constructible and move-assignable. 
+	 * @return	The new end of the range. Elements from there to last are left in a valid but unspecified state
+	 */
+	template<class Pool, class It, class Pred>
+	It parallel_remove_if(Pool& pool, It first, It last, Pred pred) {
+		typedef typename std::iterator_traits<It>::reference reference;
+		const std::vector<Pooler::index_t> offsets = detail::stableGroup(pool, first, last, 2, [&](reference value) {return pred(value) ? 1 : 0;});
+		return first + typename std::iterator_traits<It>::difference_type(offsets[pool.threadCount()]);
+	}
+
+	/* @brief Merge sorted runs into one sorted sequence, with every thread merging an equal share of the output
+	 * @description The output is cut into one segment per thread. Each thread co-ranks the start of its segment, finding how much of every run 
+	 * @description comes before it, then once every segment is co-ranked, merges its slices of the runs independently with a small heap. 
+	 * @description Equal elements keep the order of their runs, so the merge is stable. Since each element is only read by its merge once 
+	 * @description all the co-ranking is done, the runs may hand out std::move_iterator to move elements instead of copying them. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] runs	A container of sorted runs, each with begin() and end() giving random-access iterators
+	 * @param[in] out	The start of the destination, which must have room for every element
+	 * @param[in] comp	The comparison the runs are sorted by
+	 * @return	An iterator one past the last element written
+	 */
+	template<class Pool, class Runs, class OutIt, class Compare>
+	OutIt parallel_merge_runs(Pool& pool, const Runs& runs, OutIt out, Compare comp) {
+		typedef decltype(runs.begin()->begin()) It;
+
+		std::vector<std::pair<It, It>> bounds;
+		Pooler::index_t total = 0;
+		for (const auto& run : runs) {
+			bounds.push_back(std::make_pair(run.begin(), run.end()));
+			total += Pooler::index_t(run.end() - run.begin());
+		}
+
+		const std::size_t k = bounds.size();
+		const Pooler::BlockPartition segments(total, pool.threadCount());
+
+		// splits[id] is how much of every run comes before segment id
+		std::vector<std::vector<Pooler::index_t>> splits(segments.threadCount() + 1);
+		pool.run(segments, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			detail::coRank(bounds, range.begin, total, comp, splits[id]);
+		});
+		detail::coRank(bounds, total, total, comp, splits[segments.threadCount()]);
+
+		pool.run(segments, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			if (range.begin == range.end) {
+				return;
+			}
+
+			std::vector<Pooler::index_t> from = splits[id];
+			const std::vector<Pooler::index_t>& to = splits[id + 1];
+
+			// Min-heap of runs by their next element, ties going to the lower run
+			std::vector<std::size_t> heap;
+			auto later = [&](std::size_t a, std::size_t b) {
+				const auto& x = bounds[a].first[from[a]];
+				const auto& y = bounds[b].first[from[b]];
+				return comp(y, x) || (!comp(x, y) && b < a);
+			};
+
+			for (std::size_t i=0;i<k;i++) {
+				if (from[i] < to[i]) {
+					heap.push_back(i);
+				}
+			}
+			std::make_heap(heap.begin(), heap.end(), later);
+
+			OutIt destination = out + typename std::iterator_traits<OutIt>::difference_type(range.begin);
+			while (!heap.empty()) {
+				std::pop_heap(heap.begin(), heap.end(), later);
+				const std::size_t i = heap.back();
+				*destination = bounds[i].first[from[i]];
+				++destination;
+
+				if (++from[i] < to[i]) {
+					std::push_heap(heap.begin(), heap.end(), later);
+				} else {
+					heap.pop_back();
+				}
+			}
+		});
+
+		return out + typename std::iterator_traits<OutIt>::difference_type(total);
+	}
+
+	/* @brief Merge sorted runs into one sorted sequence using operator<
+	 */
+	template<class Pool, class Runs, class OutIt>
+	OutIt parallel_merge_runs(Pool& pool, const Runs& runs, OutIt out) {
+		typedef typename std::iterator_traits<decltype(runs.begin()->begin())>::value_type value_type;
+		return parallel_merge_runs(pool, runs, out, std::less<value_type>());
+	}
+	/* @brief Copy the k elements of [first, last) that come first under a comparison to out, in order
+	 * @description Each thread keeps a bounded heap of the best k elements of its block, then the per-thread candidates are 
+	 * @description sorted together on the calling thread. With the default std::greater that is the k largest, largest first. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] k	The number of elements wanted. Fewer are written if the range is shorter
+	 * @param[in] out	The start of the destination
+	 * @param[in] comp	The ordering, where comp(a, b) means a ranks above b
+	 * @return	An iterator one past the last element written
+	 */
+	template<class Pool, class It, class OutIt, class Compare>
+	OutIt parallel_top_k(Pool& pool, It first, It last, Pooler::index_t k, OutIt out, Compare comp) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+
+		const Pooler::index_t count = Pooler::index_t(last - first);
+		k = std::min(k, count);
+		if (k == 0) {
+			return out;
+		}
+
+		const Pooler::BlockPartition blocks(count, pool.threadCount());
+		std::vector<std::vector<value_type>> heaps(blocks.threadCount());
+		pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			// The worst kept element sits on top of the heap
+			std::vector<value_type>& heap = heaps[id];
+			heap.reserve(std::min(k, range.end - range.begin));
+			for (Pooler::index_t i=range.begin;i<range.end;i++) {
+				if (heap.size() < k) {
+					heap.push_back(first[i]);
+					std::push_heap(heap.begin(), heap.end(), comp);
+				} else if (comp(first[i], heap.front())) {
+					std::pop_heap(heap.begin(), heap.end(), comp);
+					heap.back() = first[i];
+					std::push_heap(heap.begin(), heap.end(), comp);
+				}
+			}
+		});
+
+		std::vector<value_type> candidates;
+		for (std::vector<value_type>& heap : heaps) {
+			std::move(heap.begin(), heap.end(), std::back_inserter(candidates));
+		}
+		std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), comp);
+		return std::move(candidates.begin(), candidates.begin() + k, out);
+	}
+
+	/* @brief Copy the k largest elements of [first, last) to out, largest first
+	 */
+	template<class Pool, class It, class OutIt>
+	OutIt parallel_top_k(Pool& pool, It first, It last, Pooler::index_t k, OutIt out) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+		return parallel_top_k(pool, first, last, k, out, std::greater<value_type>());
+	}
+
+	/* @brief Reorder [first, last) so nth holds the element a full sort would put there, with nothing after it ordered before it and nothing before it ordered after it
+	 * @description While the range is large, a pivot is picked from an evenly spaced sample at nth's relative rank, and the range is split 
+	 * @description in parallel into elements below, equal to and above it. Only the part holding nth is kept, and once it is small enough 
+	 * @description std::nth_element finishes on the calling thread. The value type must be default-constructible and move-assignable. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] nth	The position to settle
+	 * @param[in] last	The end of the range
+	 * @param[in] comp	The comparison to order by
+	 */
+	template<class Pool, class It, class Compare>
+	void parallel_nth_element(Pool& pool, It first, It nth, It last, Compare comp) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+		typedef typename std::iterator_traits<It>::reference reference;
+		typedef typename std::iterator_traits<It>::difference_type difference_type;
+
+		const Pooler::index_t SERIAL_COUNT = 16384;
+		const Pooler::index_t SAMPLES = 127;
+
+		if (nth == last) {
+			return;
+		}
+
+		while (Pooler::index_t(last - first) > SERIAL_COUNT) {
+			const Pooler::index_t count = Pooler::index_t(last - first);
+
+			std::vector<value_type> sample(SAMPLES);
+			for (Pooler::index_t i=0;i<SAMPLES;i++) {
+				sample[i] = first[difference_type(i * count / SAMPLES + count / (2 * SAMPLES))];
+			}
+			const Pooler::index_t target = Pooler::index_t(nth - first) * SAMPLES / count;
+			std::nth_element(sample.begin(), sample.begin() + difference_type(target), sample.end(), comp);
+			const value_type pivot = sample[target];
+
+			const std::vector<Pooler::index_t> offsets = detail::stableGroup(pool, first, last, 3, [&](reference value) {
+				return comp(value, pivot) ? 0 : (comp(pivot, value) ? 2 : 1);
+			});
+
+			const It equal = first + difference_type(offsets[pool.threadCount()]);
+			const It greater = first + difference_type(offsets[2 * pool.threadCount()]);
+			if (nth < equal) {
+				last = equal;
+			} else if (nth < greater) {
+				return;
+			} else {
+				first = greater;
+			}
+		}
+
+		std::nth_element(first, nth, last, comp);
+	}
+
+	/* @brief Reorder [first, last) so nth holds the element a full sort would put there, using operator<
+	 */
+	template<class Pool, class It>
+	void parallel_nth_element(Pool& pool, It first, It nth, It last) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+		parallel_nth_element(pool, first, nth, last, std::less<value_type>());
+	}
+	/* @brief Reduce a range with a function applied to a whole block at a time, one block per thread
+	 * @description The block results are combined in thread order, so for a given thread count the result is always the same. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] init	The value to start from
+	 * @param[in] reduceBlock	A callable taking the begin and end iterators of a non-empty block and returning its reduction. Called concurrently
+	 * @param[in] combine	An associative callable taking two partial results and returning their combination
+	 * @return	init combined with the reduction of every block
+	 */
+	template<class Pool, class It, class T, class ReduceBlock, class Combine>
+	T parallel_reduce_blocks(Pool& pool, It first, It last, T init, ReduceBlock reduceBlock, Combine combine) {
+		typedef typename std::iterator_traits<It>::difference_type difference_type;
+
+		const Pooler::BlockPartition blocks(Pooler::index_t(last - first), pool.threadCount());
+		std::vector<std::unique_ptr<T>> partials(blocks.threadCount());
+		pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			if (range.begin < range.end) {
+				partials[id].reset(new T(reduceBlock(first + difference_type(range.begin), first + difference_type(range.end))));
+			}
+		});
+
+		for (std::unique_ptr<T>& partial : partials) {
+			if (partial) {
+				init = combine(init, *partial);
+			}
+		}
+		return init;
+	}
+
+	/* @brief Reduce a range with an associative operation
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] init	The value to start from
+	 * @param[in] op	An associative callable taking two values and returning their combination
+	 * @return	init combined with every element
+	 */
+	template<class Pool, class It, class T, class Op>
+	T parallel_reduce(Pool& pool, It first, It last, T init, Op op) {
+		return parallel_reduce_blocks(pool, first, last, init, [&](It begin, It end) {
+			T result = *begin;
+			for (++begin;begin!=end;++begin) {
+				result = op(result, *begin);
+			}
+			return result;
+		}, op);
+	}
+
+	/* @brief Transform a range with a function applied to a whole block at a time, one block per thread
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] out	The start of the destination, which may be first
+	 * @param[in] transformBlock	A callable taking the begin and end iterators of a non-empty block and the matching destination. Called concurrently
+	 * @return	An iterator one past the last element written
+	 */
+	template<class Pool, class It, class OutIt, class TransformBlock>
+	OutIt parallel_transform_blocks(Pool& pool, It first, It last, OutIt out, TransformBlock transformBlock) {
+		typedef typename std::iterator_traits<It>::difference_type difference_type;
+		typedef typename std::iterator_traits<OutIt>::difference_type out_difference_type;
+
+		const Pooler::BlockPartition blocks(Pooler::index_t(last - first), pool.threadCount());
+		pool.run(blocks, [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			if (range.begin < range.end) {
+				transformBlock(first + difference_type(range.begin), first + difference_type(range.end), out + out_difference_type(range.begin));
+			}
+		});
+		return out + out_difference_type(last - first);
+	}
+
+	/* @brief Write fn(element) to out for every element of a range
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] out	The start of the destination, which may be first
+	 * @param[in] fn	A callable taking an element. Called concurrently
+	 * @return	An iterator one past the last element written
+	 */
+	template<class Pool, class It, class OutIt, class Fn>
+	OutIt parallel_transform(Pool& pool, It first, It last, OutIt out, Fn fn) {
+		return parallel_transform_blocks(pool, first, last, out, [&](It begin, It end, OutIt destination) {
+			std::transform(begin, end, destination, fn);
+		});
+	}
+	/* @brief Group the elements of a range by key and aggregate every group
+	 * @description Each thread pre-aggregates its block in a small hash table. Once the table holds 4096 keys, elements with 
+	 * @description new keys are no longer looked up but radix-partitioned by hash, each as its own partial aggregate. At the end every 
+	 * @description thread's table is partitioned the same way, and each thread merges a block of partitions across all threads on its own, 
+	 * @description so no lock is taken. The partitions are then copied side by side into the result. 
+	 * @param[in] pool	The pool to run on
+	 * @param[in] first	The start of the range
+	 * @param[in] last	The end of the range
+	 * @param[in] keyFn	A callable taking an element and returning its key, which must be default-constructible and work with std::hash and ==
+	 * @param[in] init	The aggregate of an empty group
+	 * @param[in] agg	A callable taking an Acc& and an element, adding the element to the aggregate
+	 * @param[in] merge	A callable taking an Acc& and a const Acc&, adding the second aggregate to the first. Must be associative
+	 * @return	One pair of key and aggregate per distinct key, in no particular order
+	 */
+	template<class Pool, class It, class KeyFn, class Acc, class Agg, class Merge>
+	std::vector<std::pair<typename std::decay<decltype(std::declval<KeyFn&>()(*std::declval<It&>()))>::type, Acc>> 
+	parallel_group_by(Pool& pool, It first, It last, KeyFn keyFn, Acc init, Agg agg, Merge merge) {
+		typedef typename std::decay<decltype(keyFn(*first))>::type Key;
+		typedef std::pair<Key, Acc> group_t;
+		typedef std::vector<group_t> partition_t;
+
+		const Pooler::index_t TABLE_LIMIT = 4096;
+
+		const Pooler::threadid_t threads = pool.threadCount();
+		uint8_t bits = 0;
+		while ((Pooler::index_t(1) << bits) < 4 * Pooler::index_t(threads) && bits < 16) {
+			bits++;
+		}
+		const Pooler::index_t partitions = Pooler::index_t(1) << bits;
+
+		std::hash<Key> hash;
+		auto partitionOf = [&](const Key& key) {
+			return bits == 0 ? 0 : Pooler::index_t((uint64_t(hash(key)) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits));
+		};
+
+		// spilled[id * partitions + p] holds thread id's partial aggregates for partition p
+		std::vector<partition_t> spilled(Pooler::index_t(threads) * partitions);
+		const Pooler::BlockPartition blocks(Pooler::index_t(last - first), threads);
+		pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			partition_t* spill = spilled.data() + Pooler::index_t(id) * partitions;
+			std::unordered_map<Key, Acc> table;
+
+			for (Pooler::index_t i=range.begin;i<range.end;i++) {
+				const auto& element = first[i];
+				Key key = keyFn(element);
+
+				typename std::unordered_map<Key, Acc>::iterator found = table.find(key);
+				if (found == table.end()) {
+					if (table.size() >= TABLE_LIMIT) {
+						// Too many keys to pre-aggregate: hand this one straight to its partition
+						Acc acc = init;
+						agg(acc, element);
+						spill[partitionOf(key)].push_back(group_t(std::move(key), std::move(acc)));
+						continue;
+					}
+					found = table.insert(std::make_pair(std::move(key), init)).first;
+				}
+				agg(found->second, element);
+			}
+
+			for (std::pair<const Key, Acc>& group : table) {
+				spill[partitionOf(group.first)].push_back(group_t(group.first, std::move(group.second)));
+			}
+		});
+
+		// Merge each partition across threads
+		std::vector<partition_t> merged(partitions);
+		pool.run(Pooler::BlockPartition(partitions, threads), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			for (Pooler::index_t p=range.begin;p<range.end;p++) {
+				std::unordered_map<Key, Acc> table;
+				for (Pooler::threadid_t id=0;id<threads;id++) {
+					partition_t& partials = spilled[Pooler::index_t(id) * partitions + p];
+					for (group_t& partial : partials) {
+						typename std::unordered_map<Key, Acc>::iterator found = table.find(partial.first);
+						if (found == table.end()) {
+							table.insert(std::move(partial));
+						} else {
+							merge(found->second, partial.second);
+						}
+					}
+					partition_t().swap(partials);
+				}
+
+				merged[p].reserve(table.size());
+				for (std::pair<const Key, Acc>& group : table) {
+					merged[p].push_back(group_t(group.first, std::move(group.second)));
+				}
+			}
+		});
+
+		std::vector<Pooler::index_t> offsets(partitions + 1, 0);
+		for (Pooler::index_t p=0;p<partitions;p++) {
+			offsets[p + 1] = offsets[p] + merged[p].size();
+		}
+
+		std::vector<group_t> result(offsets[partitions], group_t(Key(), init));
+		pool.run(Pooler::BlockPartition(partitions, threads), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			for (Pooler::index_t p=range.begin;p<range.end;p++) {
+				std::move(merged[p].begin(), merged[p].end(), result.begin() + typename std::vector<group_t>::difference_type(offsets[p]));
+			}
+		});
+		return result;
+	}
+
+	/* @brief Group the elements of a range by key and aggregate every group, using agg to merge partial aggregates too
+	 * @description For aggregates that can take an Acc in place of an element, such as summing or counting into the element's own type. 
+	 */
+	template<class Pool, class It, class KeyFn, class Acc, class Agg>
+	std::vector<std::pair<typename std::decay<decltype(std::declval<KeyFn&>()(*std::declval<It&>()))>::type, Acc>> 
+	parallel_group_by(Pool& pool, It first, It last, KeyFn keyFn, Acc init, Agg agg) {
+		return parallel_group_by(pool, first, last, keyFn, init, agg, agg);
+	}
+}
+
+#endif
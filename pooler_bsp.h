@@ -0,0 +1,214 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_BSP_H
+#define HONEYLIB_POOLER_BSP_H
+
+#include "pooler.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace pooler {
+	/* @brief 	Bulk-synchronous parallel supersteps, with messages passed between threads at every superstep barrier
+	 * @description Each superstep is one run() of the step callable on every active thread. A thread sends a message to another thread's 
+	 * @description partition with Context::send(), which appends to a buffer only the sending thread writes, one per pair of threads. 
+	 * @description At the barrier the buffers are swapped into the receivers' inboxes rather than copied, and the old inboxes are cleared 
+	 * @description to become the next outboxes, so their memory is reused for the whole computation and across calls to run(). 
+	 * @description A thread that calls voteToHalt() is skipped in later supersteps until a message reaches it. The computation ends 
+	 * @description once every thread has halted and no message is in flight. 
+	 * @param[in] Message	The type of the messages
+	 */
+	template<class Message>
+	class Bsp {
+		private:
+			const Pooler::threadid_t _threads;
+
+			// Buffer (source * threads + destination) holds what source sent destination
+			std::vector<std::vector<Message>> _outboxes;
+			std::vector<std::vector<Message>> _inboxes;
+
+		public:
+			/* @brief The messages a thread received at the last barrier. It belongs to that thread alone during the superstep, so messages may be moved out
+			 */
+			class Inbox {
+				private:
+					friend class Bsp;
+
+					Bsp& _bsp;
+					const Pooler::threadid_t _id;
+
+					Inbox(Bsp& bsp, Pooler::threadid_t id) : _bsp(bsp), _id(id) {}
+
+				public:
+					/* @brief The messages from one thread, in the order it sent them
+					 */
+					std::vector<Message>& from(Pooler::threadid_t source) {
+						return this->_bsp._inboxes[Pooler::index_t(source) * this->_bsp._threads + this->_id];
+					}
+
+					/* @brief The total number of messages
+					 */
+					Pooler::index_t size() const {
+						Pooler::index_t total = 0;
+						for (Pooler::threadid_t source=0;source<this->_bsp._threads;source++) {
+							total += this->_bsp._inboxes[Pooler::index_t(source) * this->_bsp._threads + this->_id].size();
+						}
+						return total;
+					}
+
+					/* @brief Call a function with every message, ordered by sender
+					 * @param[in] f	A callable taking a Message&
+					 */
+					template<class F>
+					void each(F f) {
+						for (Pooler::threadid_t source=0;source<this->_bsp._threads;source++) {
+							for (Message& message : this->from(source)) {
+								f(message);
+							}
+						}
+					}
+			};
+
+			/* @brief What a step sees of the computation
+			 */
+			class Context {
+				private:
+					friend class Bsp;
+
+					Bsp& _bsp;
+					const Pooler::threadid_t _id;
+					const Pooler::index_t _superstep;
+					Inbox _inbox;
+					bool _halted;
+
+					Context(Bsp& bsp, Pooler::threadid_t id, Pooler::index_t superstep) : _bsp(bsp), _id(id), _superstep(superstep), _inbox(bsp, id), _halted(false) {}
+
+				public:
+					Pooler::threadid_t id() const {
+						return this->_id;
+					}
+
+					Pooler::threadid_t threadCount() const {
+						return this->_bsp._threads;
+					}
+
+					/* @brief The number of supersteps before this one
+					 */
+					Pooler::index_t superstep() const {
+						return this->_superstep;
+					}
+
+					Inbox& inbox() {
+						return this->_inbox;
+					}
+
+					/* @brief Send a message, delivered to the destination's inbox at the start of the next superstep
+					 * @param[in] destination	The id of the receiving thread
+					 * @param[in] message	The message
+					 */
+					void send(Pooler::threadid_t destination, const Message& message) {
+						this->_bsp._outboxes[Pooler::index_t(this->_id) * this->_bsp._threads + destination].push_back(message);
+					}
+
+					void send(Pooler::threadid_t destination, Message&& message) {
+						this->_bsp._outboxes[Pooler::index_t(this->_id) * this->_bsp._threads + destination].push_back(std::move(message));
+					}
+
+					/* @brief Stop running this thread's step until a message arrives for it
+					 */
+					void voteToHalt() {
+						this->_halted = true;
+					}
+			};
+
+			/* @brief Construct a new BSP computation for a pool
+			 * @param[in] pool	The pool it will run on, a Pooler or a FixedPooler<N>
+			 */
+			template<class Pool>
+			explicit Bsp(const Pool& pool) : _threads(pool.threadCount()), 
+				_outboxes(Pooler::index_t(pool.threadCount()) * pool.threadCount()), _inboxes(Pooler::index_t(pool.threadCount()) * pool.threadCount()) {}
+
+			/* @brief Run supersteps until every thread has halted with no message in flight, or a limit is reached
+			 * @description Throws std::invalid_argument if the pool's thread count differs from the one given at construction. 
+			 * @param[in] pool	The pool to run on, with the thread count given at construction
+			 * @param[in] step	A callable taking a Context&, run on every active thread once per superstep
+			 * @param[in] maxSupersteps	The most supersteps to run. Messages sent in the last one are dropped if it is reached
+			 * @return	The number of supersteps run
+			 */
+			template<class Pool, class Step>
+			Pooler::index_t run(Pool& pool, Step step, Pooler::index_t maxSupersteps = ~Pooler::index_t(0)) {
+				if (pool.threadCount() != this->_threads) {
+					throw std::invalid_argument("pooler::Bsp: the pool's thread count differs from the one given at construction");
+				}
+
+				const Pooler::threadid_t threads = this->_threads;
+				std::vector<uint8_t> halted(threads, 0);
+				std::vector<uint8_t> active(threads, 0);
+
+				Pooler::index_t superstep = 0;
+				for (;superstep<maxSupersteps;superstep++) {
+					// The barrier: hand every outbox to its receiver, and recycle the read inboxes as empty outboxes
+					for (Pooler::index_t i=0;i<this->_outboxes.size();i++) {
+						this->_inboxes[i].swap(this->_outboxes[i]);
+						this->_outboxes[i].clear();
+					}
+
+					bool any = false;
+					for (Pooler::threadid_t id=0;id<threads;id++) {
+						active[id] = !halted[id];
+						for (Pooler::threadid_t source=0;source<threads && !active[id];source++) {
+							active[id] = !this->_inboxes[Pooler::index_t(source) * threads + id].empty();
+						}
+						any = any || active[id];
+					}
+
+					if (!any) {
+						break;
+					}
+
+					pool.run([&](Pooler::threadid_t id, void*) {
+						if (!active[id]) {
+							return;
+						}
+
+						Context context(*this, id, superstep);
+						step(context);
+						halted[id] = context._halted;
+					});
+				}
+
+				for (Pooler::index_t i=0;i<this->_outboxes.size();i++) {
+					this->_inboxes[i].clear();
+					this->_outboxes[i].clear();
+				}
+				return superstep;
+			}
+	};
+}
+
+#endif
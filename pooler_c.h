@@ -0,0 +1,179 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_C_H
+#define HONEYLIB_POOLER_C_H
+
+/* A C interface to pooler.h, so code written in other languages can share the same workers as the C++ code in a process. 
+ * 
+ * This header is header-only: define POOLER_C_IMPLEMENTATION in exactly one C++ translation unit before including it to compile the implementation. 
+ * pooler_c.cpp does exactly that, and can be built as a shared library for FFI consumers:
+ * 	c++ -std=c++11 -O2 -shared -fPIC -DPOOLER_C_BUILD pooler_c.cpp -o libpooler.so -pthread
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+	#if defined(POOLER_C_BUILD)
+		#define POOLER_C_API __declspec(dllexport)
+	#else
+		#define POOLER_C_API __declspec(dllimport)
+	#endif
+#elif defined(__GNUC__)
+	#define POOLER_C_API __attribute__((visibility("default")))
+#else
+	#define POOLER_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* @brief An opaque handle to a thread pool */
+typedef struct pooler_s pooler_t;
+
+/* @brief A callback performed by every thread in the pool
+ * @param[out] id	The id of the running thread, from 0 to N (where N is the pool's thread count)
+ * @param[out] data	The pointer provided to pooler_run()
+ */
+typedef void (*pooler_func_t)(uint16_t id, void* data);
+
+/* @brief A callback performed by every thread in the pool over the block of a loop it was handed
+ * @param[out] id	The id of the running thread, from 0 to N (where N is the pool's thread count)
+ * @param[out] begin	The first index of this thread's block
+ * @param[out] end	One past the last index of this thread's block
+ * @param[out] data	The pointer provided to pooler_parallel_for()
+ */
+typedef void (*pooler_range_func_t)(uint16_t id, size_t begin, size_t end, void* data);
+
+/* @brief Create a new thread pool
+ * @param[in] threadCount	The number of threads this pool will use
+ * @return	A new pool, or NULL if the threads could not be started
+ */
+POOLER_C_API pooler_t* pooler_create(uint16_t threadCount);
+
+/* @brief Stop all threads of a pool created by pooler_create() and free it. Passing the shared pool or NULL does nothing. 
+ */
+POOLER_C_API void pooler_destroy(pooler_t* pool);
+
+/* @brief Get the process-wide pool, creating it with one thread per hardware thread on first use
+ * @description Every library and language binding that calls this receives the same pool, so they all share one set of workers. 
+ * @return	The shared pool, or NULL if the threads could not be started
+ */
+POOLER_C_API pooler_t* pooler_shared(void);
+
+/* @brief Get the number of threads in a pool
+ */
+POOLER_C_API uint16_t pooler_thread_count(const pooler_t* pool);
+
+/* @brief Run a callback in all threads of a pool, and block until every thread has returned
+ * @description Calls from several threads are serialized. Calling this from inside a callback running on the same pool deadlocks. 
+ * @param[in] pool	The pool to run on
+ * @param[in] callback	The callback to perform in every thread
+ * @param[in] data	A pointer passed to every thread
+ */
+POOLER_C_API void pooler_run(pooler_t* pool, pooler_func_t callback, void* data);
+
+/* @brief Split [begin, end) into one contiguous block per thread, and run a callback over each block
+ * @description Calls from several threads are serialized. Calling this from inside a callback running on the same pool deadlocks. 
+ * @param[in] pool	The pool to run on
+ * @param[in] begin	The first index of the loop
+ * @param[in] end	One past the last index of the loop
+ * @param[in] callback	The callback to perform in every thread
+ * @param[in] data	A pointer passed to every thread
+ */
+POOLER_C_API void pooler_parallel_for(pooler_t* pool, size_t begin, size_t end, pooler_range_func_t callback, void* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(POOLER_C_IMPLEMENTATION) && defined(__cplusplus)
+
+#include "pooler.h"
+
+#include <algorithm>
+#include <atomic>
+
+struct pooler_s {
+	Pooler pool;
+
+	pooler_s(Pooler::threadid_t threadCount) : pool(threadCount) {}
+};
+
+// Set by pooler_shared() once the shared pool exists, so pooler_destroy() can recognize it without creating it
+static std::atomic<pooler_t*> poolerSharedPool(NULL);
+
+extern "C" {
+
+POOLER_C_API pooler_t* pooler_create(uint16_t threadCount) {
+	if (threadCount == 0) {
+		return NULL;
+	}
+
+	try {
+		return new pooler_s(threadCount);
+	} catch (...) {
+		return NULL;
+	}
+}
+
+POOLER_C_API void pooler_destroy(pooler_t* pool) {
+	if (pool == NULL || pool == poolerSharedPool.load()) {
+		return;
+	}
+
+	pool->pool.stop();
+	delete pool;
+}
+
+POOLER_C_API pooler_t* pooler_shared(void) {
+	// Intentionally leaked, so the workers outlive every static destructor that might still submit work
+	static pooler_t* shared = pooler_create(Pooler::threadid_t(std::max(1u, std::min(std::thread::hardware_concurrency(), 65535u))));
+	poolerSharedPool = shared;
+	return shared;
+}
+
+POOLER_C_API uint16_t pooler_thread_count(const pooler_t* pool) {
+	return pool->pool.threadCount();
+}
+
+POOLER_C_API void pooler_run(pooler_t* pool, pooler_func_t callback, void* data) {
+	pool->pool.run(callback, data);
+}
+
+POOLER_C_API void pooler_parallel_for(pooler_t* pool, size_t begin, size_t end, pooler_range_func_t callback, void* data) {
+	pool->pool.parallel_for(begin, end, [callback](Pooler::threadid_t id, const Pooler::Range& range, void* param) {
+		callback(id, range.begin, range.end, param);
+	}, data);
+}
+
+}
+
+#endif
+#endif
@@ -0,0 +1,511 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_CONTAINERS_H
+#define HONEYLIB_POOLER_CONTAINERS_H
+
+#include "pooler.h"
+
+#include <iterator>
+#include <functional>
+#include <utility>
+#include <new>
+#include <thread>
+
+/* Containers that a pool's callbacks can fill concurrently. 
+ */
+namespace pooler {
+	/* @brief 	An append-only vector that callbacks on every thread can add to at once
+	 * @description Storage is a list of segments that double in size and never move, so appending never copies existing elements 
+	 * @description and a reference to an element stays valid until the vector is cleared. Reserving room for a batch takes one atomic add. 
+	 * @description Segments are raw storage, and each element is copy-constructed in place when it is appended, so T only needs to be 
+	 * @description copy-constructible. Its copy constructor should not throw. Read elements once the run that appended them has ended. 
+	 * @param[in] T	The type of the elements
+	 */
+	template<class T>
+	class ConcurrentVector {
+		private:
+			// The size of the first segment. Segment k holds FIRST_SEGMENT << k elements
+			static const Pooler::index_t FIRST_SEGMENT = 64;
+			static const uint8_t SEGMENTS = 48;
+
+			std::atomic<Pooler::index_t> _size;
+			std::atomic<T*> _segments[SEGMENTS];
+
+			/* @brief Stands in for a segment while the thread that claimed it allocates it
+			 */
+			static T* claimed() {
+				return reinterpret_cast<T*>(uintptr_t(1));
+			}
+
+			/* @brief The segment holding an index
+			 */
+			static uint8_t segment(Pooler::index_t i) {
+				uint64_t blocks = uint64_t(i / FIRST_SEGMENT) + 1;
+				uint8_t log = 0;
+				while (blocks >>= 1) {
+					log++;
+				}
+				return log;
+			}
+
+			/* @brief The index of the first element of a segment
+			 */
+			static Pooler::index_t segmentBegin(uint8_t k) {
+				return FIRST_SEGMENT * ((Pooler::index_t(1) << k) - 1);
+			}
+
+			static Pooler::index_t segmentSize(uint8_t k) {
+				return FIRST_SEGMENT << k;
+			}
+
+			/* @brief Get a segment, allocating it if no thread has yet
+			 * @description The first thread to find the segment missing claims it and allocates it. Any other thread needing it 
+			 * @description meanwhile waits for the pointer to be published, so each segment is only ever allocated once. 
+			 */
+			T* allocate(uint8_t k) {
+				T* current = this->_segments[k].load();
+				if (current == nullptr && this->_segments[k].compare_exchange_strong(current, claimed())) {
+					current = static_cast<T*>(::operator new(sizeof(T) * segmentSize(k)));
+					this->_segments[k].store(current);
+				}
+				while (current == claimed()) {
+					std::this_thread::yield();
+					current = this->_segments[k].load();
+				}
+				return current;
+			}
+
+			/* @brief The storage for an index, whether or not an element has been constructed there yet
+			 */
+			T* slot(Pooler::index_t i) const {
+				const uint8_t k = segment(i);
+				return this->_segments[k].load() + (i - segmentBegin(k));
+			}
+
+			/* @brief Reserve room for a batch of elements at the end of the vector, without constructing them
+			 */
+			Pooler::index_t reserve(Pooler::index_t count) {
+				const Pooler::index_t first = this->_size.fetch_add(count);
+				if (count > 0) {
+					for (uint8_t k=segment(first);k<=segment(first + count - 1);k++) {
+						this->allocate(k);
+					}
+				}
+				return first;
+			}
+
+		public:
+			ConcurrentVector() : _size(0) {
+				for (uint8_t k=0;k<SEGMENTS;k++) {
+					this->_segments[k] = nullptr;
+				}
+			}
+
+			ConcurrentVector(const ConcurrentVector&) = delete;
+			ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+			~ConcurrentVector() {
+				this->clear();
+			}
+
+			/* @brief Add a batch of copies of one value at the end of the vector. Safe to call from any number of threads
+			 * @param[in] count	The number of elements to add
+			 * @param[in] value	The value to copy into each. Defaults to T(), which is only needed when it is left out
+			 * @return	The index of the first added element. The caller can then overwrite [index, index + count) through operator[]
+			 */
+			Pooler::index_t grow(Pooler::index_t count, const T& value = T()) {
+				const Pooler::index_t first = this->reserve(count);
+				for (Pooler::index_t i=first;i<first + count;i++) {
+					new (this->slot(i)) T(value);
+				}
+				return first;
+			}
+
+			/* @brief Append one element. Safe to call from any number of threads
+			 * @return	The index of the element
+			 */
+			Pooler::index_t push_back(const T& value) {
+				const Pooler::index_t index = this->reserve(1);
+				new (this->slot(index)) T(value);
+				return index;
+			}
+
+			/* @brief Append a batch of elements, kept together and in order. Safe to call from any number of threads
+			 * @param[in] first	The start of the elements to append
+			 * @param[in] last	The end of the elements to append
+			 * @return	The index of the first appended element
+			 */
+			template<class It>
+			Pooler::index_t append(It first, It last) {
+				const Pooler::index_t begin = this->reserve(Pooler::index_t(std::distance(first, last)));
+				for (Pooler::index_t i=begin;first!=last;++first, i++) {
+					new (this->slot(i)) T(*first);
+				}
+				return begin;
+			}
+
+			T& operator[](Pooler::index_t i) {
+				return *this->slot(i);
+			}
+
+			const T& operator[](Pooler::index_t i) const {
+				return *this->slot(i);
+			}
+
+			/* @brief The number of elements reserved so far
+			 */
+			Pooler::index_t size() const {
+				return this->_size.load();
+			}
+
+			/* @brief Remove every element and free the segments. No thread may be appending
+			 */
+			void clear() {
+				const Pooler::index_t count = this->size();
+				for (uint8_t k=0;k<SEGMENTS;k++) {
+					T* storage = this->_segments[k].exchange(nullptr);
+					if (storage != nullptr) {
+						const Pooler::index_t constructed = count > segmentBegin(k) ? std::min(count - segmentBegin(k), segmentSize(k)) : 0;
+						for (Pooler::index_t i=0;i<constructed;i++) {
+							storage[i].~T();
+						}
+						::operator delete(storage);
+					}
+				}
+				this->_size = 0;
+			}
+
+			/* @brief Copy every element into contiguous storage, in parallel
+			 * @description Each thread copies one block of the output, a segment-sized piece at a time. 
+			 * @param[in] pool	The pool to run on, a Pooler or a FixedPooler<N>
+			 * @param[in] out	The start of the destination, which must have room for size() elements
+			 * @return	An iterator one past the last element written
+			 */
+			template<class Pool, class OutIt>
+			OutIt flatten(Pool& pool, OutIt out) const {
+				typedef typename std::iterator_traits<OutIt>::difference_type difference_type;
+
+				const Pooler::index_t count = this->size();
+				pool.run(Pooler::BlockPartition(count, pool.threadCount()), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+					Pooler::index_t i = range.begin;
+					while (i < range.end) {
+						const uint8_t k = segment(i);
+						const Pooler::index_t end = std::min(range.end, segmentBegin(k) + segmentSize(k));
+						const T* source = this->slot(i);
+						std::copy(source, source + (end - i), out + difference_type(i));
+						i = end;
+					}
+				});
+				return out + difference_type(count);
+			}
+
+			/* @brief Copy every element into a new std::vector, in parallel
+			 * @description The vector is sized up front, so this form needs T to be default-constructible and assignable. 
+			 */
+			template<class Pool>
+			std::vector<T> flatten(Pool& pool) const {
+				std::vector<T> result(this->size());
+				this->flatten(pool, result.begin());
+				return result;
+			}
+	};
+	/* @brief 	A hash map that callbacks on every thread can use at once
+	 * @description Keys are spread over a power-of-two number of shards, each an open-addressing table with linear probing and its own lock, 
+	 * @description so threads only contend when they touch the same shard. Inserting never overwrites: the first value for a key is kept. 
+	 * @description For building a whole map at once, bulkInsert() has each thread buffer its pairs by shard, then builds the shards in parallel without locks. 
+	 * @param[in] K	The type of the keys. Must be default-constructible and copyable
+	 * @param[in] V	The type of the values. Must be default-constructible and copyable
+	 * @param[in] Hash	The hash function
+	 * @param[in] Equal	The key comparison
+	 */
+	template<class K, class V, class Hash = std::hash<K>, class Equal = std::equal_to<K>>
+	class ConcurrentHashMap {
+		private:
+			// A table grows once it is this many tenths full
+			static const uint8_t MAX_LOAD = 7;
+			static const Pooler::index_t FIRST_CAPACITY = 16;
+
+			struct Shard {
+				mutable std::mutex lock;
+				std::vector<K> keys;
+				std::vector<V> values;
+				std::vector<uint8_t> used;
+				Pooler::index_t size;
+				char padding[64];
+
+				Shard() : size(0) {}
+			};
+
+			std::unique_ptr<Shard[]> _shards;
+			uint32_t _shardCount;
+			uint8_t _shardBits;
+			Hash _hash;
+			Equal _equal;
+
+			/* @brief Mix a key's hash, since std::hash of an integer is often the integer itself
+			 */
+			uint64_t mix(const K& key) const {
+				return uint64_t(this->_hash(key)) * UINT64_C(0x9E3779B97F4A7C15);
+			}
+
+			/* @brief The shard a mixed hash belongs to, from its high bits
+			 */
+			uint32_t shardOf(uint64_t mixed) const {
+				return this->_shardBits == 0 ? 0 : uint32_t(mixed >> (64 - this->_shardBits));
+			}
+
+			/* @brief Find a key's slot in a shard, or the empty slot where it would go. The shard must have room
+			 */
+			Pooler::index_t probe(const Shard& shard, const K& key, uint64_t mixed) const {
+				const Pooler::index_t mask = shard.keys.size() - 1;
+				Pooler::index_t slot = Pooler::index_t(mixed) & mask;
+				while (shard.used[slot] && !this->_equal(shard.keys[slot], key)) {
+					slot = (slot + 1) & mask;
+				}
+				return slot;
+			}
+
+			/* @brief Make room for one more key in a shard, doubling its table if it is too full
+			 */
+			void makeRoom(Shard& shard) {
+				if ((shard.size + 1) * 10 <= shard.keys.size() * MAX_LOAD) {
+					return;
+				}
+
+				Shard grown;
+				const Pooler::index_t capacity = shard.keys.empty() ? FIRST_CAPACITY : 2 * shard.keys.size();
+				grown.keys.resize(capacity);
+				grown.values.resize(capacity);
+				grown.used.assign(capacity, 0);
+				for (Pooler::index_t i=0;i<shard.keys.size();i++) {
+					if (shard.used[i]) {
+						const Pooler::index_t slot = this->probe(grown, shard.keys[i], this->mix(shard.keys[i]));
+						grown.keys[slot] = std::move(shard.keys[i]);
+						grown.values[slot] = std::move(shard.values[i]);
+						grown.used[slot] = 1;
+					}
+				}
+
+				shard.keys.swap(grown.keys);
+				shard.values.swap(grown.values);
+				shard.used.swap(grown.used);
+			}
+
+			/* @brief Find or add a key in a shard whose lock is held, or which no other thread can reach
+			 * @param[out] inserted	Set to true if the key was added
+			 * @return	The key's slot
+			 */
+			Pooler::index_t locate(Shard& shard, const K& key, uint64_t mixed, bool& inserted) {
+				this->makeRoom(shard);
+				const Pooler::index_t slot = this->probe(shard, key, mixed);
+				inserted = !shard.used[slot];
+				if (inserted) {
+					shard.keys[slot] = key;
+					shard.used[slot] = 1;
+					shard.size++;
+				}
+				return slot;
+			}
+
+		public:
+			/* @brief Buffers one thread's pairs by shard during bulkInsert()
+			 */
+			class BulkInserter {
+				private:
+					friend class ConcurrentHashMap;
+
+					const ConcurrentHashMap* _map;
+					std::vector<std::vector<std::pair<K, V>>> _buffers;
+
+					BulkInserter(const ConcurrentHashMap* map) : _map(map), _buffers(map->_shardCount) {}
+
+				public:
+					void insert(const K& key, const V& value) {
+						this->_buffers[this->_map->shardOf(this->_map->mix(key))].push_back(std::make_pair(key, value));
+					}
+			};
+
+			/* @brief Construct a new empty map
+			 * @param[in] shards	The number of shards, rounded up to a power of two. A few times the number of threads that insert at once works well
+			 */
+			ConcurrentHashMap(uint32_t shards = 64, const Hash& hash = Hash(), const Equal& equal = Equal()) : _shardCount(1), _shardBits(0), _hash(hash), _equal(equal) {
+				while (this->_shardCount < shards && this->_shardBits < 16) {
+					this->_shardCount <<= 1;
+					this->_shardBits++;
+				}
+				this->_shards.reset(new Shard[this->_shardCount]);
+			}
+
+			ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+			ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+			/* @brief Add a key, unless it is already present. Safe to call from any number of threads
+			 * @return	True if the key was added, false if it was already present and its value was left alone
+			 */
+			bool insert(const K& key, const V& value) {
+				const uint64_t mixed = this->mix(key);
+				Shard& shard = this->_shards[this->shardOf(mixed)];
+				std::lock_guard<std::mutex> lock(shard.lock);
+
+				bool inserted;
+				const Pooler::index_t slot = this->locate(shard, key, mixed, inserted);
+				if (inserted) {
+					shard.values[slot] = value;
+				}
+				return inserted;
+			}
+
+			/* @brief Apply a function to a key's value, adding the key with a default-constructed value first if it is missing. Safe to call from any number of threads
+			 * @param[in] key	The key
+			 * @param[in] f	A callable taking a V&. Called with the shard locked, so it should be short
+			 */
+			template<class F>
+			void update(const K& key, F f) {
+				const uint64_t mixed = this->mix(key);
+				Shard& shard = this->_shards[this->shardOf(mixed)];
+				std::lock_guard<std::mutex> lock(shard.lock);
+
+				bool inserted;
+				const Pooler::index_t slot = this->locate(shard, key, mixed, inserted);
+				if (inserted) {
+					shard.values[slot] = V();
+				}
+				f(shard.values[slot]);
+			}
+
+			/* @brief Look up a key. Safe to call from any number of threads
+			 * @param[in] key	The key
+			 * @param[out] value	Set to the key's value if it is present
+			 * @return	True if the key is present
+			 */
+			bool find(const K& key, V& value) const {
+				const uint64_t mixed = this->mix(key);
+				const Shard& shard = this->_shards[this->shardOf(mixed)];
+				std::lock_guard<std::mutex> lock(shard.lock);
+
+				if (shard.size == 0) {
+					return false;
+				}
+
+				const Pooler::index_t slot = this->probe(shard, key, mixed);
+				if (!shard.used[slot]) {
+					return false;
+				}
+				value = shard.values[slot];
+				return true;
+			}
+
+			bool contains(const K& key) const {
+				V value;
+				return this->find(key, value);
+			}
+
+			/* @brief The number of keys
+			 */
+			Pooler::index_t size() const {
+				Pooler::index_t total = 0;
+				for (uint32_t i=0;i<this->_shardCount;i++) {
+					std::lock_guard<std::mutex> lock(this->_shards[i].lock);
+					total += this->_shards[i].size;
+				}
+				return total;
+			}
+
+			/* @brief Call a function with every key and value. No thread may be inserting
+			 * @param[in] f	A callable taking a const K& and a V&
+			 */
+			template<class F>
+			void each(F f) {
+				for (uint32_t i=0;i<this->_shardCount;i++) {
+					Shard& shard = this->_shards[i];
+					for (Pooler::index_t slot=0;slot<shard.keys.size();slot++) {
+						if (shard.used[slot]) {
+							f(static_cast<const K&>(shard.keys[slot]), shard.values[slot]);
+						}
+					}
+				}
+			}
+
+			/* @brief Remove every key. No thread may be using the map
+			 */
+			void clear() {
+				this->_shards.reset(new Shard[this->_shardCount]);
+			}
+
+			/* @brief Insert many pairs at once, with every thread producing pairs and then building its share of the shards
+			 * @description The first run calls produce on every thread, which buffers its pairs by shard in its own BulkInserter. 
+			 * @description The second run gives each thread a block of shards to fill from every buffer, in thread order, without locking. 
+			 * @description When a key is produced more than once, the pair from the lowest thread id, then the earliest, wins. No other thread may use the map meanwhile. 
+			 * @param[in] pool	The pool to run on, a Pooler or a FixedPooler<N>
+			 * @param[in] produce	A callable taking the thread id and a BulkInserter&, like a run() callback
+			 */
+			template<class Pool, class Produce>
+			void bulkInsert(Pool& pool, Produce produce) {
+				std::vector<BulkInserter> inserters(pool.threadCount(), BulkInserter(this));
+				pool.run([&](Pooler::threadid_t id, void*) {
+					produce(id, inserters[id]);
+				});
+
+				pool.run(Pooler::BlockPartition(this->_shardCount, pool.threadCount()), [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+					for (Pooler::index_t i=range.begin;i<range.end;i++) {
+						Shard& shard = this->_shards[i];
+						for (BulkInserter& inserter : inserters) {
+							for (const std::pair<K, V>& pair : inserter._buffers[i]) {
+								bool inserted;
+								const Pooler::index_t slot = this->locate(shard, pair.first, this->mix(pair.first), inserted);
+								if (inserted) {
+									shard.values[slot] = pair.second;
+								}
+							}
+							std::vector<std::pair<K, V>>().swap(inserter._buffers[i]);
+						}
+					}
+				});
+			}
+
+			/* @brief Insert a range of key and value pairs at once, each thread buffering a block of them
+			 * @param[in] pool	The pool to run on, a Pooler or a FixedPooler<N>
+			 * @param[in] first	The start of the pairs, as random-access iterators to something with .first and .second
+			 * @param[in] last	The end of the pairs
+			 */
+			template<class Pool, class It>
+			void bulkInsert(Pool& pool, It first, It last) {
+				typedef typename std::iterator_traits<It>::difference_type difference_type;
+
+				const Pooler::BlockPartition blocks(Pooler::index_t(last - first), pool.threadCount());
+				this->bulkInsert(pool, [&](Pooler::threadid_t id, BulkInserter& inserter) {
+					const Pooler::Range range = blocks.range(id);
+					for (It pair=first+difference_type(range.begin);pair!=first+difference_type(range.end);++pair) {
+						inserter.insert(pair->first, pair->second);
+					}
+				});
+			}
+	};
+}
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_EXECUTION_H
+#define HONEYLIB_POOLER_EXECUTION_H
+
+#include "pooler_algorithm.h"
+
+#include <iterator>
+#include <functional>
+
+/* Standard algorithm entry points that run on a pool instead of a separate parallel backend. 
+ * Each takes pooler::par(pool) where the standard overload takes an execution policy, and otherwise mirrors it: 
+ * @code
+ * 	pooler::for_each(pooler::par(pool), v.begin(), v.end(), f);		// std::for_each(std::execution::par, v.begin(), v.end(), f)
+ * 	const double dot = pooler::transform_reduce(pooler::par(pool), x.begin(), x.end(), y.begin(), 0.0);
+ * @endcode
+ * The policy lives in namespace pooler, so unqualified calls also find these overloads through argument-dependent lookup. 
+ * Iterators must be random-access. Reductions are grouped per thread, so the operations must be associative and commutative, as with std::execution::par. 
+ */
+namespace pooler {
+	/* @brief 	An execution policy naming the pool to run on, a Pooler or a FixedPooler<N>
+	 */
+	template<class Pool>
+	struct ExecutionPolicy {
+		Pool& pool;
+	};
+
+	/* @brief Make an execution policy that runs algorithms on a pool
+	 */
+	template<class Pool>
+	ExecutionPolicy<Pool> par(Pool& pool) {
+		return ExecutionPolicy<Pool>{pool};
+	}
+
+	namespace detail {
+		// A sorted block handed to parallel_merge_runs(), moving its elements out
+		template<class It>
+		struct MoveSpan {
+			It first;
+			It last;
+
+			std::move_iterator<It> begin() const {
+				return std::move_iterator<It>(this->first);
+			}
+
+			std::move_iterator<It> end() const {
+				return std::move_iterator<It>(this->last);
+			}
+		};
+	}
+
+	template<class Pool, class It, class F>
+	void for_each(const ExecutionPolicy<Pool>& policy, It first, It last, F f) {
+		parallel_transform_blocks(policy.pool, first, last, first, [&](It begin, It end, It) {
+			std::for_each(begin, end, f);
+		});
+	}
+
+	template<class Pool, class It, class Size, class F>
+	It for_each_n(const ExecutionPolicy<Pool>& policy, It first, Size n, F f) {
+		const It last = first + n;
+		pooler::for_each(policy, first, last, f);
+		return last;
+	}
+
+	template<class Pool, class It, class OutIt, class F>
+	OutIt transform(const ExecutionPolicy<Pool>& policy, It first, It last, OutIt out, F f) {
+		return parallel_transform(policy.pool, first, last, out, f);
+	}
+
+	template<class Pool, class It1, class It2, class OutIt, class F>
+	OutIt transform(const ExecutionPolicy<Pool>& policy, It1 first1, It1 last1, It2 first2, OutIt out, F f) {
+		return parallel_transform_blocks(policy.pool, first1, last1, out, [&](It1 begin, It1 end, OutIt destination) {
+			std::transform(begin, end, first2 + (begin - first1), destination, f);
+		});
+	}
+
+	template<class Pool, class It, class T, class Op>
+	T reduce(const ExecutionPolicy<Pool>& policy, It first, It last, T init, Op op) {
+		return parallel_reduce(policy.pool, first, last, init, op);
+	}
+
+	template<class Pool, class It, class T>
+	T reduce(const ExecutionPolicy<Pool>& policy, It first, It last, T init) {
+		return pooler::reduce(policy, first, last, init, std::plus<T>());
+	}
+
+	template<class Pool, class It>
+	typename std::iterator_traits<It>::value_type reduce(const ExecutionPolicy<Pool>& policy, It first, It last) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+		return pooler::reduce(policy, first, last, value_type(), std::plus<value_type>());
+	}
+
+	template<class Pool, class It, class T, class ReduceOp, class TransformOp>
+	T transform_reduce(const ExecutionPolicy<Pool>& policy, It first, It last, T init, ReduceOp reduceOp, TransformOp transformOp) {
+		return parallel_reduce_blocks(policy.pool, first, last, init, [&](It begin, It end) {
+			T result = transformOp(*begin);
+			for (++begin;begin!=end;++begin) {
+				result = reduceOp(result, transformOp(*begin));
+			}
+			return result;
+		}, reduceOp);
+	}
+
+	template<class Pool, class It1, class It2, class T, class ReduceOp, class TransformOp>
+	T transform_reduce(const ExecutionPolicy<Pool>& policy, It1 first1, It1 last1, It2 first2, T init, ReduceOp reduceOp, TransformOp transformOp) {
+		return parallel_reduce_blocks(policy.pool, first1, last1, init, [&](It1 begin, It1 end) {
+			It2 other = first2 + (begin - first1);
+			T result = transformOp(*begin, *other);
+			for (++begin, ++other;begin!=end;++begin, ++other) {
+				result = reduceOp(result, transformOp(*begin, *other));
+			}
+			return result;
+		}, reduceOp);
+	}
+
+	template<class Pool, class It1, class It2, class T>
+	T transform_reduce(const ExecutionPolicy<Pool>& policy, It1 first1, It1 last1, It2 first2, T init) {
+		return pooler::transform_reduce(policy, first1, last1, first2, init, std::plus<T>(), std::multiplies<T>());
+	}
+
+	template<class Pool, class It, class Pred>
+	typename std::iterator_traits<It>::difference_type count_if(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		typedef typename std::iterator_traits<It>::difference_type difference_type;
+		return parallel_reduce_blocks(policy.pool, first, last, difference_type(0), [&](It begin, It end) {
+			return difference_type(std::count_if(begin, end, pred));
+		}, std::plus<difference_type>());
+	}
+
+	template<class Pool, class It, class T>
+	typename std::iterator_traits<It>::difference_type count(const ExecutionPolicy<Pool>& policy, It first, It last, const T& value) {
+		typedef typename std::iterator_traits<It>::reference reference;
+		return pooler::count_if(policy, first, last, [&](reference element) {return element == value;});
+	}
+
+	template<class Pool, class It, class Pred>
+	It find_if(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_find_if(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class T>
+	It find(const ExecutionPolicy<Pool>& policy, It first, It last, const T& value) {
+		typedef typename std::iterator_traits<It>::reference reference;
+		return parallel_find_if(policy.pool, first, last, [&](reference element) {return element == value;});
+	}
+
+	template<class Pool, class It, class Pred>
+	bool any_of(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_any_of(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class Pred>
+	bool all_of(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_all_of(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class Pred>
+	bool none_of(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_none_of(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class OutIt, class Pred>
+	OutIt copy_if(const ExecutionPolicy<Pool>& policy, It first, It last, OutIt out, Pred pred) {
+		return parallel_copy_if(policy.pool, first, last, out, pred);
+	}
+
+	template<class Pool, class It, class OutIt>
+	OutIt copy(const ExecutionPolicy<Pool>& policy, It first, It last, OutIt out) {
+		return parallel_transform_blocks(policy.pool, first, last, out, [](It begin, It end, OutIt destination) {
+			std::copy(begin, end, destination);
+		});
+	}
+
+	template<class Pool, class It, class T>
+	void fill(const ExecutionPolicy<Pool>& policy, It first, It last, const T& value) {
+		parallel_transform_blocks(policy.pool, first, last, first, [&](It begin, It end, It) {
+			std::fill(begin, end, value);
+		});
+	}
+
+	template<class Pool, class It, class Pred>
+	It remove_if(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_remove_if(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class Pred>
+	It stable_partition(const ExecutionPolicy<Pool>& policy, It first, It last, Pred pred) {
+		return parallel_stable_partition(policy.pool, first, last, pred);
+	}
+
+	template<class Pool, class It, class Compare>
+	void nth_element(const ExecutionPolicy<Pool>& policy, It first, It nth, It last, Compare comp) {
+		parallel_nth_element(policy.pool, first, nth, last, comp);
+	}
+
+	template<class Pool, class It>
+	void nth_element(const ExecutionPolicy<Pool>& policy, It first, It nth, It last) {
+		parallel_nth_element(policy.pool, first, nth, last);
+	}
+
+	/* @brief Sort a range stably: every thread sorts its block, then the blocks are merged in parallel through a buffer
+	 * @description The value type must be default-constructible and move-assignable. 
+	 */
+	template<class Pool, class It, class Compare>
+	void stable_sort(const ExecutionPolicy<Pool>& policy, It first, It last, Compare comp) {
+		typedef typename std::iterator_traits<It>::value_type value_type;
+		typedef typename std::iterator_traits<It>::difference_type difference_type;
+
+		const Pooler::BlockPartition blocks(Pooler::index_t(last - first), policy.pool.threadCount());
+		std::vector<detail::MoveSpan<It>> runs(blocks.threadCount());
+		policy.pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+			runs[id] = detail::MoveSpan<It>{first + difference_type(range.begin), first + difference_type(range.end)};
+			std::stable_sort(runs[id].first, runs[id].last, comp);
+		});
+
+		std::vector<value_type> buffer(Pooler::index_t(last - first));
+		parallel_merge_runs(policy.pool, runs, buffer.begin(), comp);
+		parallel_transform_blocks(policy.pool, buffer.begin(), buffer.end(), first, [](typename std::vector<value_type>::iterator begin, typename std::vector<value_type>::iterator end, It destination) {
+			std::move(begin, end, destination);
+		});
+	}
+
+	template<class Pool, class It>
+	void stable_sort(const ExecutionPolicy<Pool>& policy, It first, It last) {
+		pooler::stable_sort(policy, first, last, std::less<typename std::iterator_traits<It>::value_type>());
+	}
+
+	/* @brief Sort a range. The same as stable_sort(), which the parallel merge gives for free
+	 */
+	template<class Pool, class It, class Compare>
+	void sort(const ExecutionPolicy<Pool>& policy, It first, It last, Compare comp) {
+		pooler::stable_sort(policy, first, last, comp);
+	}
+
+	template<class Pool, class It>
+	void sort(const ExecutionPolicy<Pool>& policy, It first, It last) {
+		pooler::stable_sort(policy, first, last);
+	}
+}
+
+#endif
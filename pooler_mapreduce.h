@@ -0,0 +1,274 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_MAPREDUCE_H
+#define HONEYLIB_POOLER_MAPREDUCE_H
+
+#include "pooler.h"
+
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace pooler {
+	/* @brief 	An in-memory MapReduce engine running every phase on one pool
+	 * @description Map: each thread maps a block of the input. Emitted pairs go into buffers for that thread, one per partition of the keys. 
+	 * @description With a combiner, values are first combined per key in a small table for each buffer. 
+	 * @description Shuffle and reduce: each thread takes a block of partitions, groups every thread's pairs for them by key, 
+	 * @description and reduces every group. The results of all threads are then moved side by side into the output. 
+	 * @description The buffers, the combining tables and the key groups are kept between jobs, nodes and value vectors included. 
+	 * @description Keys are held by value, so apart from copying the keys it emits, a warm job over keys seen before only allocates its results. 
+	 * @param[in] K	The type of the keys. Must work with Hash and ==
+	 * @param[in] V	The type of the values
+	 * @param[in] Hash	The hash function
+	 */
+	template<class K, class V, class Hash = std::hash<K>>
+	class MapReduce {
+		private:
+			// A combining table is flushed to its buffer once it holds this many keys
+			static const Pooler::index_t COMBINE_LIMIT = 1024;
+
+			// Stands in for the combiner of a job without one
+			struct NoCombine {};
+
+			typedef std::pair<K, V> pair_t;
+
+			// A value in a combining table. Entries left unused by a flush keep their node for the key's next value
+			struct Combined {
+				V value;
+				bool used;
+			};
+
+			template<class Reduce>
+			struct ReduceResult {
+				typedef typename std::decay<decltype(std::declval<Reduce&>()(std::declval<const K&>(), std::declval<std::vector<V>&>()))>::type type;
+			};
+
+			const Pooler::threadid_t _threads;
+			Pooler::index_t _partitions;
+			uint8_t _partitionBits;
+			Hash _hash;
+
+			// Buffer and table (thread * partitions + partition) hold what a thread emitted for a partition
+			std::vector<std::vector<pair_t>> _buffers;
+			std::vector<std::unordered_map<K, Combined, Hash>> _tables;
+			std::vector<Pooler::index_t> _tableUsed;
+			std::vector<std::unordered_map<K, std::vector<V>, Hash>> _groups;
+
+			Pooler::index_t partitionOf(const K& key) const {
+				return this->_partitionBits == 0 ? 0 : Pooler::index_t((uint64_t(this->_hash(key)) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - this->_partitionBits));
+			}
+
+			/* @brief Fail loudly when a pool doesn't have the thread count the buffers were sized for
+			 */
+			template<class Pool>
+			void checkPool(const Pool& pool) const {
+				if (pool.threadCount() != this->_threads) {
+					throw std::invalid_argument("pooler::MapReduce: the pool's thread count differs from the one given at construction");
+				}
+			}
+
+			/* @brief Move a combining table's used values into its buffer
+			 */
+			void flush(Pooler::index_t slot) {
+				std::unordered_map<K, Combined, Hash>& table = this->_tables[slot];
+				for (std::pair<const K, Combined>& entry : table) {
+					if (entry.second.used) {
+						this->_buffers[slot].push_back(pair_t(entry.first, std::move(entry.second.value)));
+						entry.second.used = false;
+					}
+				}
+				this->_tableUsed[slot] = 0;
+
+				// Past twice the limit, walking the unused nodes costs more than allocating new ones would
+				if (table.size() > 2 * COMBINE_LIMIT) {
+					table.clear();
+				}
+			}
+
+			void emitTo(Pooler::index_t slot, const K& key, const V& value, NoCombine&) {
+				this->_buffers[slot].push_back(pair_t(key, value));
+			}
+
+			template<class Combine>
+			void emitTo(Pooler::index_t slot, const K& key, const V& value, Combine& combine) {
+				std::unordered_map<K, Combined, Hash>& table = this->_tables[slot];
+				typename std::unordered_map<K, Combined, Hash>::iterator found = table.find(key);
+				if (found != table.end() && found->second.used) {
+					combine(found->second.value, value);
+					return;
+				}
+
+				if (this->_tableUsed[slot] >= COMBINE_LIMIT) {
+					this->flush(slot);
+					found = table.find(key);
+				}
+
+				if (found != table.end()) {
+					found->second.value = value;
+					found->second.used = true;
+				} else {
+					table.insert(std::make_pair(key, Combined{value, true}));
+				}
+				this->_tableUsed[slot]++;
+			}
+
+		public:
+			/* @brief Collects what one thread's map tasks emit
+			 * @description Map callables take an Emitter<>& in jobs without a combiner, and an Emitter<Combine>& in jobs with one, 
+			 * @description such as MapReduce<K, V>::Emitter<decltype(combine)>&, so the combiner is called directly. 
+			 * @param[in] Combine	The type of the job's combiner
+			 */
+			template<class Combine = NoCombine>
+			class Emitter {
+				private:
+					friend class MapReduce;
+
+					MapReduce& _job;
+					const Pooler::threadid_t _id;
+					Combine& _combine;
+
+					Emitter(MapReduce& job, Pooler::threadid_t id, Combine& combine) : _job(job), _id(id), _combine(combine) {}
+
+				public:
+					void emit(const K& key, const V& value) {
+						this->_job.emitTo(Pooler::index_t(this->_id) * this->_job._partitions + this->_job.partitionOf(key), key, value, this->_combine);
+					}
+			};
+
+			/* @brief Construct a new MapReduce engine for a pool
+			 * @param[in] pool	The pool it will run on, a Pooler or a FixedPooler<N>
+			 * @param[in] partitions	The number of key partitions, rounded up to a power of two, or 0 for four per thread
+			 */
+			template<class Pool>
+			explicit MapReduce(const Pool& pool, Pooler::index_t partitions = 0) : _threads(pool.threadCount()), _partitions(1), _partitionBits(0) {
+				if (partitions == 0) {
+					partitions = 4 * Pooler::index_t(this->_threads);
+				}
+				while (this->_partitions < partitions && this->_partitionBits < 16) {
+					this->_partitions <<= 1;
+					this->_partitionBits++;
+				}
+
+				this->_buffers.resize(Pooler::index_t(this->_threads) * this->_partitions);
+				this->_tables.resize(Pooler::index_t(this->_threads) * this->_partitions);
+				this->_tableUsed.resize(Pooler::index_t(this->_threads) * this->_partitions, 0);
+				this->_groups.resize(this->_partitions);
+			}
+
+			/* @brief Run a job with a combiner
+			 * @description Throws std::invalid_argument if the pool's thread count differs from the one given at construction. 
+			 * @param[in] pool	The pool to run on
+			 * @param[in] first	The start of the input, a random-access iterator
+			 * @param[in] last	The end of the input
+			 * @param[in] map	A callable taking an input element and an Emitter<Combine>&. Called concurrently
+			 * @param[in] combine	A callable taking a V& and a const V&, folding the second value into the first. Must be associative. Copied once per thread
+			 * @param[in] reduce	A callable taking a const K& and a std::vector<V>& of every value for the key, returning the key's result. Called concurrently
+			 * @return	One pair of key and result per distinct key, in no particular order
+			 */
+			template<class Pool, class It, class Map, class Combine, class Reduce>
+			std::vector<std::pair<K, typename ReduceResult<Reduce>::type>> run(Pool& pool, It first, It last, Map map, Combine combine, Reduce reduce) {
+				typedef typename std::iterator_traits<It>::difference_type difference_type;
+				typedef typename ReduceResult<Reduce>::type result_t;
+				typedef std::vector<std::pair<K, result_t>> results_t;
+
+				this->checkPool(pool);
+
+				// Map, a block of the input per thread
+				pool.run(Pooler::BlockPartition(Pooler::index_t(last - first), this->_threads), [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+					Combine threadCombine = combine;
+					Emitter<Combine> emitter(*this, id, threadCombine);
+					for (It input=first+difference_type(range.begin);input!=first+difference_type(range.end);++input) {
+						map(*input, emitter);
+					}
+
+					if (!std::is_same<Combine, NoCombine>::value) {
+						for (Pooler::index_t p=0;p<this->_partitions;p++) {
+							this->flush(Pooler::index_t(id) * this->_partitions + p);
+						}
+					}
+				});
+
+				// Shuffle and reduce, a block of partitions per thread
+				std::vector<results_t> reduced(this->_threads);
+				pool.run(Pooler::BlockPartition(this->_partitions, this->_threads), [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+					for (Pooler::index_t p=range.begin;p<range.end;p++) {
+						std::unordered_map<K, std::vector<V>, Hash>& groups = this->_groups[p];
+						Pooler::index_t live = 0;
+						for (Pooler::threadid_t source=0;source<this->_threads;source++) {
+							std::vector<pair_t>& buffer = this->_buffers[Pooler::index_t(source) * this->_partitions + p];
+							for (pair_t& pair : buffer) {
+								std::vector<V>& values = groups[pair.first];
+								live += values.empty();
+								values.push_back(std::move(pair.second));
+							}
+							buffer.clear();
+						}
+
+						// Keys left over from earlier jobs are kept for reuse, until they outnumber this job's
+						if (groups.size() > 2 * live) {
+							for (typename std::unordered_map<K, std::vector<V>, Hash>::iterator group=groups.begin();group!=groups.end();) {
+								group = group->second.empty() ? groups.erase(group) : std::next(group);
+							}
+						}
+
+						for (std::pair<const K, std::vector<V>>& group : groups) {
+							if (!group.second.empty()) {
+								reduced[id].push_back(std::make_pair(group.first, reduce(group.first, group.second)));
+								group.second.clear();
+							}
+						}
+					}
+				});
+
+				Pooler::index_t total = 0;
+				for (const results_t& results : reduced) {
+					total += results.size();
+				}
+
+				results_t results;
+				results.reserve(total);
+				for (results_t& threadResults : reduced) {
+					for (std::pair<K, result_t>& result : threadResults) {
+						results.push_back(std::move(result));
+					}
+				}
+				return results;
+			}
+
+			/* @brief Run a job without a combiner. Map callables take an Emitter<>&
+			 */
+			template<class Pool, class It, class Map, class Reduce>
+			std::vector<std::pair<K, typename ReduceResult<Reduce>::type>> run(Pool& pool, It first, It last, Map map, Reduce reduce) {
+				return this->run(pool, first, last, map, NoCombine(), reduce);
+			}
+	};
+}
+
+#endif
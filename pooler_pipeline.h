@@ -0,0 +1,281 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_PIPELINE_H
+#define HONEYLIB_POOLER_PIPELINE_H
+
+#include "pooler.h"
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+/* Range pipelines fused into a single loop over the pool. 
+ * A pipeline starts from a range, goes through any number of transform() and filter() stages, and ends in reduce() or collect(): 
+ * @code
+ * 	const double sum = pooler::pipeline(pool, x.begin(), x.end())
+ * 		| pooler::transform([](double v) {return v * v;})
+ * 		| pooler::filter([](double v) {return v > 1.0;})
+ * 		| pooler::reduce(0.0, std::plus<double>());
+ * @endcode
+ * The stages are composed into one type, so the compiler inlines them into a single loop over each thread's block: 
+ * the whole pipeline takes one run() and one pass over memory, and nothing is stored between stages. 
+ */
+namespace pooler {
+	namespace detail {
+		// The stage of a pipeline with no adaptors: hands elements on untouched
+		struct IdentityStage {
+			template<class T, class Sink>
+			void operator()(T&& value, Sink& sink) const {
+				sink(std::forward<T>(value));
+			}
+		};
+
+		template<class F, class Sink>
+		struct TransformSink {
+			F& f;
+			Sink& sink;
+
+			template<class T>
+			void operator()(T&& value) {
+				this->sink(this->f(std::forward<T>(value)));
+			}
+		};
+
+		// Runs the earlier stages, then hands their output through f. Not const, so mutable callables can keep state
+		template<class Previous, class F>
+		struct TransformStage {
+			Previous previous;
+			F f;
+
+			template<class T, class Sink>
+			void operator()(T&& value, Sink& sink) {
+				TransformSink<F, Sink> next{this->f, sink};
+				this->previous(std::forward<T>(value), next);
+			}
+		};
+
+		template<class Pred, class Sink>
+		struct FilterSink {
+			Pred& pred;
+			Sink& sink;
+
+			template<class T>
+			void operator()(T&& value) {
+				if (this->pred(value)) {
+					this->sink(std::forward<T>(value));
+				}
+			}
+		};
+
+		// Runs the earlier stages, then drops what fails pred
+		template<class Previous, class Pred>
+		struct FilterStage {
+			Previous previous;
+			Pred pred;
+
+			template<class T, class Sink>
+			void operator()(T&& value, Sink& sink) {
+				FilterSink<Pred, Sink> next{this->pred, sink};
+				this->previous(std::forward<T>(value), next);
+			}
+		};
+
+		template<class T, class Op>
+		struct ReduceSink {
+			const Op* op;
+			T result;
+			bool empty;
+
+			template<class V>
+			void operator()(V&& value) {
+				if (this->empty) {
+					this->result = std::forward<V>(value);
+					this->empty = false;
+				} else {
+					this->result = (*this->op)(this->result, std::forward<V>(value));
+				}
+			}
+		};
+
+		template<class T>
+		struct CollectSink {
+			std::vector<T>* out;
+
+			template<class V>
+			void operator()(V&& value) {
+				this->out->push_back(std::forward<V>(value));
+			}
+		};
+	}
+
+	template<class F>
+	struct TransformAdaptor {
+		F f;
+	};
+
+	template<class Pred>
+	struct FilterAdaptor {
+		Pred pred;
+	};
+
+	template<class T, class Op>
+	struct ReduceTerminal {
+		T init;
+		Op op;
+	};
+
+	struct CollectTerminal {};
+
+	/* @brief A pipeline stage applying a function to every element
+	 * @param[in] f	A callable taking an element. Copied once per thread for every pipeline run, so a mutable callable keeps separate state per thread
+	 */
+	template<class F>
+	TransformAdaptor<F> transform(F f) {
+		return TransformAdaptor<F>{f};
+	}
+
+	/* @brief A pipeline stage keeping only the elements that satisfy a predicate
+	 * @param[in] pred	A callable taking an element and returning bool. Copied once per thread for every pipeline run, like transform()'s callable
+	 */
+	template<class Pred>
+	FilterAdaptor<Pred> filter(Pred pred) {
+		return FilterAdaptor<Pred>{pred};
+	}
+
+	/* @brief End a pipeline by combining its elements
+	 * @description Each thread folds its own elements, then the thread results are folded in thread order onto init. 
+	 * @param[in] init	The value to start from
+	 * @param[in] op	An associative callable taking two values and returning their combination
+	 */
+	template<class T, class Op>
+	ReduceTerminal<T, Op> reduce(T init, Op op) {
+		return ReduceTerminal<T, Op>{init, op};
+	}
+
+	/* @brief End a pipeline by gathering its elements into a std::vector, in the order of the range
+	 */
+	inline CollectTerminal collect() {
+		return CollectTerminal();
+	}
+
+	/* @brief 	A range and the stages applied to it, waiting for a terminal. Built by pipeline() and operator|
+	 * @param[in] Value	The type of the elements coming out of the last stage
+	 */
+	template<class Pool, class It, class Stage, class Value>
+	class Pipeline {
+		private:
+			Pool& _pool;
+			It _first;
+			It _last;
+			Stage _stage;
+
+			/* @brief Push every element of the range through the stages into one sink per thread, in a single run
+			 * @param[in] sinks	One sink per thread
+			 */
+			template<class Sink>
+			void drive(std::vector<Sink>& sinks) const {
+				typedef typename std::iterator_traits<It>::difference_type difference_type;
+
+				const Pooler::BlockPartition blocks(Pooler::index_t(this->_last - this->_first), this->_pool.threadCount());
+				this->_pool.run(blocks, [&](Pooler::threadid_t id, const Pooler::Range& range, void*) {
+					// A local copy lets the compiler keep the sink's state in registers. 
+					// The stages are copied too, so each thread has its own state for mutable callables
+					Sink sink = sinks[id];
+					Stage stage = this->_stage;
+					for (It i=this->_first+difference_type(range.begin);i!=this->_first+difference_type(range.end);++i) {
+						stage(*i, sink);
+					}
+					sinks[id] = sink;
+				});
+			}
+
+		public:
+			Pipeline(Pool& pool, It first, It last, Stage stage) : _pool(pool), _first(first), _last(last), _stage(stage) {}
+
+			template<class F>
+			Pipeline<Pool, It, detail::TransformStage<Stage, F>, typename std::decay<decltype(std::declval<F&>()(std::declval<Value>()))>::type> 
+			operator|(const TransformAdaptor<F>& adaptor) const {
+				return {this->_pool, this->_first, this->_last, detail::TransformStage<Stage, F>{this->_stage, adaptor.f}};
+			}
+
+			template<class Pred>
+			Pipeline<Pool, It, detail::FilterStage<Stage, Pred>, Value> operator|(const FilterAdaptor<Pred>& adaptor) const {
+				return {this->_pool, this->_first, this->_last, detail::FilterStage<Stage, Pred>{this->_stage, adaptor.pred}};
+			}
+
+			template<class T, class Op>
+			T operator|(const ReduceTerminal<T, Op>& terminal) const {
+				std::vector<detail::ReduceSink<T, Op>> sinks(this->_pool.threadCount(), detail::ReduceSink<T, Op>{&terminal.op, terminal.init, true});
+				this->drive(sinks);
+
+				T result = terminal.init;
+				for (const detail::ReduceSink<T, Op>& sink : sinks) {
+					if (!sink.empty) {
+						result = terminal.op(result, sink.result);
+					}
+				}
+				return result;
+			}
+
+			/* @brief Gather into a std::vector. The thread results are moved onto its end in thread order, so Value only needs to be movable
+			 */
+			std::vector<Value> operator|(const CollectTerminal&) const {
+				const Pooler::threadid_t threads = this->_pool.threadCount();
+				std::vector<std::vector<Value>> parts(threads);
+				std::vector<detail::CollectSink<Value>> sinks;
+				for (std::vector<Value>& part : parts) {
+					sinks.push_back(detail::CollectSink<Value>{&part});
+				}
+				this->drive(sinks);
+
+				Pooler::index_t total = 0;
+				for (const std::vector<Value>& part : parts) {
+					total += part.size();
+				}
+
+				std::vector<Value> result;
+				result.reserve(total);
+				for (std::vector<Value>& part : parts) {
+					std::move(part.begin(), part.end(), std::back_inserter(result));
+				}
+				return result;
+			}
+	};
+
+	/* @brief Start a pipeline over a range
+	 * @param[in] pool	The pool to run on, a Pooler or a FixedPooler<N>. Nothing runs until a terminal is applied
+	 * @param[in] first	The start of the range, a random-access iterator
+	 * @param[in] last	The end of the range
+	 */
+	template<class Pool, class It>
+	Pipeline<Pool, It, detail::IdentityStage, typename std::iterator_traits<It>::value_type> pipeline(Pool& pool, It first, It last) {
+		return {pool, first, last, detail::IdentityStage()};
+	}
+}
+
+#endif
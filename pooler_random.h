@@ -0,0 +1,238 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_RANDOM_H
+#define HONEYLIB_POOLER_RANDOM_H
+
+#include "pooler.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* Counter-based random numbers for work spread over a pool. 
+ * A value is a pure function of a seed, a stream and a position, so streams keyed by the logical item being computed 
+ * give the same results whatever the thread count or the schedule, and there is no engine state to share or to keep in cache. 
+ */
+namespace pooler {
+	/* @brief The Philox4x32-10 block function of Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"
+	 */
+	class Philox {
+	public:
+		typedef std::array<uint32_t, 4> counter_t;
+		typedef std::array<uint32_t, 2> key_t;
+
+		static const uint8_t ROUNDS = 10;
+
+		/* @brief Encrypt a counter with a key, giving four random words
+		 * @param[in] counter	The counter to encrypt
+		 * @param[in] key	The key to encrypt it with
+		 * @return	Four uniformly distributed 32-bit words
+		 */
+		static inline counter_t block(counter_t counter, key_t key) {
+			for (uint8_t round=0;round<ROUNDS;round++) {
+				const uint64_t product0 = uint64_t(M0) * counter[0];
+				const uint64_t product1 = uint64_t(M1) * counter[2];
+				counter = {{
+					uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+					uint32_t(product1),
+					uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+					uint32_t(product0)
+				}};
+				key[0] += W0;
+				key[1] += W1;
+			}
+			return counter;
+		}
+
+		/* @brief Fill an array with consecutive blocks of a stream
+		 * @description Works on a batch of independent counters at a time, laid out so that the rounds vectorise. 
+		 * @param[in] seed	The seed, used as the key
+		 * @param[in] stream	The stream, which makes up the high half of every counter
+		 * @param[in] firstBlock	The position of the first block in the stream
+		 * @param[out] out	Where to write the words, four per block
+		 * @param[in] blocks	The number of blocks to write
+		 */
+		static inline void generate(uint64_t seed, uint64_t stream, uint64_t firstBlock, uint32_t* out, std::size_t blocks) {
+			const uint32_t LANES = 8;
+
+			std::size_t done = 0;
+			for (;done+LANES<=blocks;done+=LANES) {
+				uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+				for (uint32_t lane=0;lane<LANES;lane++) {
+					const uint64_t position = firstBlock + done + lane;
+					c0[lane] = uint32_t(position);
+					c1[lane] = uint32_t(position >> 32);
+					c2[lane] = uint32_t(stream);
+					c3[lane] = uint32_t(stream >> 32);
+				}
+
+				uint32_t k0 = uint32_t(seed);
+				uint32_t k1 = uint32_t(seed >> 32);
+				for (uint8_t round=0;round<ROUNDS;round++) {
+					for (uint32_t lane=0;lane<LANES;lane++) {
+						const uint64_t product0 = uint64_t(M0) * c0[lane];
+						const uint64_t product1 = uint64_t(M1) * c2[lane];
+						c0[lane] = uint32_t(product1 >> 32) ^ c1[lane] ^ k0;
+						c1[lane] = uint32_t(product1);
+						c2[lane] = uint32_t(product0 >> 32) ^ c3[lane] ^ k1;
+						c3[lane] = uint32_t(product0);
+					}
+					k0 += W0;
+					k1 += W1;
+				}
+
+				for (uint32_t lane=0;lane<LANES;lane++) {
+					uint32_t* words = out + 4 * (done + lane);
+					words[0] = c0[lane];
+					words[1] = c1[lane];
+					words[2] = c2[lane];
+					words[3] = c3[lane];
+				}
+			}
+
+			for (;done<blocks;done++) {
+				const counter_t words = Philox::block(Philox::counter(stream, firstBlock + done), Philox::key(seed));
+				for (uint8_t i=0;i<4;i++) {
+					out[4 * done + i] = words[i];
+				}
+			}
+		}
+
+		/* @brief The counter for a block of a stream
+		 */
+		static inline counter_t counter(uint64_t stream, uint64_t position) {
+			return {{uint32_t(position), uint32_t(position >> 32), uint32_t(stream), uint32_t(stream >> 32)}};
+		}
+
+		/* @brief The key for a seed
+		 */
+		static inline key_t key(uint64_t seed) {
+			return {{uint32_t(seed), uint32_t(seed >> 32)}};
+		}
+
+	private:
+		static const uint32_t M0 = 0xD2511F53;
+		static const uint32_t M1 = 0xCD9E8D57;
+		static const uint32_t W0 = 0x9E3779B9;
+		static const uint32_t W1 = 0xBB67AE85;
+	};
+
+	/* @brief A random stream keyed by a seed and a logical index, such as the item being computed
+	 * @description Meets the UniformRandomBitGenerator requirements, so it works with the <random> distributions. 
+	 * @description It is a few words in size and cheap to make, so make one per item inside the loop rather than one per thread: 
+	 * @description @code
+	 * @description 	pool.parallel_for(0, paths, [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+	 * @description 		for (Pooler::index_t i=range.begin;i<range.end;i++) {
+	 * @description 			pooler::RandomStream random(seed, i);
+	 * @description 			...
+	 * @description 		}
+	 * @description 	});
+	 * @description @endcode
+	 */
+	class RandomStream {
+	public:
+		typedef uint32_t result_type;
+
+		/* @brief Create a stream
+		 * @param[in] seed	The seed shared by a whole computation
+		 * @param[in] stream	The index of the stream, usually the item it is used for
+		 */
+		RandomStream(uint64_t seed, uint64_t stream) : _key(Philox::key(seed)), _stream(stream), _position(0), _used(4) {}
+
+		static constexpr result_type min() {
+			return 0;
+		}
+
+		static constexpr result_type max() {
+			return 0xFFFFFFFF;
+		}
+
+		/* @brief The next 32 random bits
+		 */
+		result_type operator()() {
+			if (this->_used == 4) {
+				this->_words = Philox::block(Philox::counter(this->_stream, this->_position++), this->_key);
+				this->_used = 0;
+			}
+			return this->_words[this->_used++];
+		}
+
+		/* @brief A uniformly distributed double in [0, 1), using 53 random bits
+		 */
+		double uniform() {
+			const uint64_t high = (*this)();
+			const uint64_t low = (*this)();
+			return double(((high << 32) | low) >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		/* @brief Skip ahead
+		 * @param[in] count	The number of 32-bit values to skip
+		 */
+		void discard(uint64_t count) {
+			const uint64_t offset = (this->_used == 4 ? 4 * this->_position : 4 * (this->_position - 1) + this->_used) + count;
+			this->_position = offset / 4;
+			this->_used = 4;
+			if (offset % 4) {
+				(*this)();
+				this->_used = uint8_t(offset % 4);
+			}
+		}
+
+	private:
+		Philox::key_t _key;
+		uint64_t _stream;
+		uint64_t _position;
+		Philox::counter_t _words;
+		uint8_t _used;
+	};
+
+	/* @brief Fill an array with random words in parallel, giving the same contents whatever the pool size
+	 * @description Word i is word (i % 4) of block (i / 4) of the stream, so this matches a RandomStream read from the start. 
+	 * @param[in] pool	The pool to run on, a Pooler or a FixedPooler<N>
+	 * @param[in] seed	The seed
+	 * @param[in] stream	The stream
+	 * @param[out] out	The array to fill
+	 * @param[in] count	The number of words to write
+	 */
+	template<class Pool>
+	void parallel_random_fill(Pool& pool, uint64_t seed, uint64_t stream, uint32_t* out, std::size_t count) {
+		const Pooler::BlockPartition blocks(Pooler::index_t(count / 4), pool.threadCount());
+		pool.run(blocks, [&](Pooler::threadid_t, const Pooler::Range& range, void*) {
+			Philox::generate(seed, stream, range.begin, out + 4 * range.begin, range.end - range.begin);
+		});
+
+		if (count % 4) {
+			const Philox::counter_t words = Philox::block(Philox::counter(stream, count / 4), Philox::key(seed));
+			for (std::size_t i=0;i<count%4;i++) {
+				out[count - count % 4 + i] = words[i];
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,486 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+*/
+
+#ifndef HONEYLIB_POOLER_SIMD_H
+#define HONEYLIB_POOLER_SIMD_H
+
+#include "pooler_algorithm.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POOLER_SIMD_X86
+#define __POOLER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(__GNUC__)
+#define POOLER_SIMD_VECTORS
+#define __POOLER_SIMD_INLINE inline __attribute__((always_inline))
+#endif
+
+// Keeps GCC from auto-vectorizing the scalar kernels, so the SCALAR instruction set really runs one element at a time
+#if defined(__GNUC__) && !defined(__clang__)
+#define __POOLER_SIMD_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define __POOLER_SIMD_SCALAR
+#endif
+
+/* Vector kernels for the inner loops of the parallel algorithms, picked at run time. 
+ * The kernels are written once with GCC/Clang vector extensions and compiled for each instruction set through target attributes, 
+ * so the library does not need to be built with -mavx2 or -mavx512f to use them. The widest set the CPU and OS support, 
+ * as reported by CPUID, is picked the first time a kernel is called. Other compilers and CPUs get the same kernels 
+ * at the baseline vector width, or plain loops. 
+ * Floating point sums are computed in a different order than a serial loop, so they can differ from one in the last bits. 
+ */
+namespace pooler {
+	namespace simd {
+		enum Isa {
+			SCALAR,
+			SSE2,
+			AVX2,
+			AVX512
+		};
+
+		/* @brief Find the widest instruction set this CPU and OS support
+		 */
+		inline Isa detect() {
+#ifdef POOLER_SIMD_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f")) {
+				return AVX512;
+			}
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+				return AVX2;
+			}
+			if (__builtin_cpu_supports("sse2")) {
+				return SSE2;
+			}
+#endif
+			return SCALAR;
+		}
+
+		namespace detail {
+			inline Isa& selected() {
+				static Isa isa = detect();
+				return isa;
+			}
+		}
+
+		/* @brief The instruction set the kernels run with
+		 */
+		inline Isa isa() {
+			return detail::selected();
+		}
+
+		/* @brief Restrict the kernels to an instruction set, for testing or comparing them. Sets wider than the CPU supports are ignored
+		 * @description SCALAR runs plain loops on x86. Elsewhere no set is detected, and the vector kernels always run at the base width. 
+		 * @description Not thread safe: call it while no kernel is running. 
+		 * @param[in] limit	The widest instruction set to use
+		 */
+		inline void setIsa(Isa limit) {
+			detail::selected() = (limit < detect()) ? limit : detect();
+		}
+
+		namespace detail {
+			// Plain loops, run for the SCALAR instruction set and by compilers without vector extensions
+			template<class T>
+			__POOLER_SIMD_SCALAR inline T sumScalar(const T* x, std::size_t n) {
+				T result = 0;
+				for (std::size_t i=0;i<n;i++) {
+					result += x[i];
+				}
+				return result;
+			}
+
+			template<class T>
+			__POOLER_SIMD_SCALAR inline T dotScalar(const T* x, const T* y, std::size_t n) {
+				T result = 0;
+				for (std::size_t i=0;i<n;i++) {
+					result += x[i] * y[i];
+				}
+				return result;
+			}
+
+			template<class T>
+			__POOLER_SIMD_SCALAR inline T minScalar(const T* x, std::size_t n) {
+				T result = std::numeric_limits<T>::infinity();
+				for (std::size_t i=0;i<n;i++) {
+					result = x[i] < result ? x[i] : result;
+				}
+				return result;
+			}
+
+			template<class T>
+			__POOLER_SIMD_SCALAR inline T maxScalar(const T* x, std::size_t n) {
+				T result = -std::numeric_limits<T>::infinity();
+				for (std::size_t i=0;i<n;i++) {
+					result = x[i] > result ? x[i] : result;
+				}
+				return result;
+			}
+
+			template<class T>
+			__POOLER_SIMD_SCALAR inline void axpyScalar(T a, const T* x, T* y, std::size_t n) {
+				for (std::size_t i=0;i<n;i++) {
+					y[i] += a * x[i];
+				}
+			}
+
+			__POOLER_SIMD_SCALAR inline void histogramScalar(const float* x, std::size_t n, float low, float high, uint64_t* counts, uint32_t bins) {
+				const float scale = float(bins) / (high - low);
+				for (std::size_t i=0;i<n;i++) {
+					if (x[i] >= low && x[i] < high) {
+						const uint32_t bin = uint32_t((x[i] - low) * scale);
+						counts[bin < bins ? bin : bins - 1]++;
+					}
+				}
+			}
+
+#ifdef POOLER_SIMD_VECTORS
+			template<class T, std::size_t BYTES>
+			struct Vector {
+				typedef T type __attribute__((vector_size(BYTES)));
+				static const std::size_t LANES = BYTES / sizeof(T);
+			};
+
+			template<class T, std::size_t BYTES>
+			__POOLER_SIMD_INLINE T sumKernel(const T* x, std::size_t n) {
+				typedef typename Vector<T, BYTES>::type V;
+				const std::size_t LANES = Vector<T, BYTES>::LANES;
+
+				// Four accumulators hide the latency of the adds
+				V acc0 = {}, acc1 = {}, acc2 = {}, acc3 = {};
+				std::size_t i = 0;
+				for (;i+4*LANES<=n;i+=4*LANES) {
+					V v0, v1, v2, v3;
+					std::memcpy(&v0, x + i, BYTES);
+					std::memcpy(&v1, x + i + LANES, BYTES);
+					std::memcpy(&v2, x + i + 2 * LANES, BYTES);
+					std::memcpy(&v3, x + i + 3 * LANES, BYTES);
+					acc0 += v0;
+					acc1 += v1;
+					acc2 += v2;
+					acc3 += v3;
+				}
+				for (;i+LANES<=n;i+=LANES) {
+					V v;
+					std::memcpy(&v, x + i, BYTES);
+					acc0 += v;
+				}
+
+				acc0 += acc1 + acc2 + acc3;
+				T result = 0;
+				for (std::size_t lane=0;lane<LANES;lane++) {
+					result += acc0[lane];
+				}
+				for (;i<n;i++) {
+					result += x[i];
+				}
+				return result;
+			}
+
+			template<class T, std::size_t BYTES>
+			__POOLER_SIMD_INLINE T dotKernel(const T* x, const T* y, std::size_t n) {
+				typedef typename Vector<T, BYTES>::type V;
+				const std::size_t LANES = Vector<T, BYTES>::LANES;
+
+				V acc0 = {}, acc1 = {};
+				std::size_t i = 0;
+				for (;i+2*LANES<=n;i+=2*LANES) {
+					V x0, x1, y0, y1;
+					std::memcpy(&x0, x + i, BYTES);
+					std::memcpy(&x1, x + i + LANES, BYTES);
+					std::memcpy(&y0, y + i, BYTES);
+					std::memcpy(&y1, y + i + LANES, BYTES);
+					acc0 += x0 * y0;
+					acc1 += x1 * y1;
+				}
+				for (;i+LANES<=n;i+=LANES) {
+					V xv, yv;
+					std::memcpy(&xv, x + i, BYTES);
+					std::memcpy(&yv, y + i, BYTES);
+					acc0 += xv * yv;
+				}
+
+				acc0 += acc1;
+				T result = 0;
+				for (std::size_t lane=0;lane<LANES;lane++) {
+					result += acc0[lane];
+				}
+				for (;i<n;i++) {
+					result += x[i] * y[i];
+				}
+				return result;
+			}
+
+			template<class T, std::size_t BYTES, bool MAX>
+			__POOLER_SIMD_INLINE T extremeKernel(const T* x, std::size_t n) {
+				typedef typename Vector<T, BYTES>::type V;
+				const std::size_t LANES = Vector<T, BYTES>::LANES;
+
+				T result = MAX ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+				std::size_t i = 0;
+				if (n >= LANES) {
+					V acc;
+					std::memcpy(&acc, x, BYTES);
+					for (i=LANES;i+LANES<=n;i+=LANES) {
+						V v;
+						std::memcpy(&v, x + i, BYTES);
+						acc = MAX ? (v > acc ? v : acc) : (v < acc ? v : acc);
+					}
+					for (std::size_t lane=0;lane<LANES;lane++) {
+						result = MAX ? (acc[lane] > result ? acc[lane] : result) : (acc[lane] < result ? acc[lane] : result);
+					}
+				}
+				for (;i<n;i++) {
+					result = MAX ? (x[i] > result ? x[i] : result) : (x[i] < result ? x[i] : result);
+				}
+				return result;
+			}
+
+			template<class T, std::size_t BYTES>
+			__POOLER_SIMD_INLINE void axpyKernel(T a, const T* x, T* y, std::size_t n) {
+				typedef typename Vector<T, BYTES>::type V;
+				const std::size_t LANES = Vector<T, BYTES>::LANES;
+
+				std::size_t i = 0;
+				for (;i+LANES<=n;i+=LANES) {
+					V xv, yv;
+					std::memcpy(&xv, x + i, BYTES);
+					std::memcpy(&yv, y + i, BYTES);
+					yv += a * xv;
+					std::memcpy(y + i, &yv, BYTES);
+				}
+				for (;i<n;i++) {
+					y[i] += a * x[i];
+				}
+			}
+
+			template<std::size_t BYTES>
+			__POOLER_SIMD_INLINE void histogramKernel(const float* x, std::size_t n, float low, float high, uint64_t* counts, uint32_t bins) {
+				typedef typename Vector<float, BYTES>::type V;
+				typedef typename Vector<int32_t, BYTES>::type I;
+				const std::size_t LANES = Vector<float, BYTES>::LANES;
+				const float scale = float(bins) / (high - low);
+				const int32_t last = int32_t(bins - 1);
+
+				// Bins are worked out a vector at a time; only the increments are scalar
+				std::size_t i = 0;
+				for (;i+LANES<=n;i+=LANES) {
+					V v;
+					std::memcpy(&v, x + i, BYTES);
+					const I inside = (v >= low) & (v < high);
+					I bin = __builtin_convertvector((v - low) * scale, I);
+					bin = bin < last ? bin : last;
+					for (std::size_t lane=0;lane<LANES;lane++) {
+						if (inside[lane]) {
+							counts[bin[lane]]++;
+						}
+					}
+				}
+				for (;i<n;i++) {
+					if (x[i] >= low && x[i] < high) {
+						const int32_t bin = int32_t((x[i] - low) * scale);
+						counts[bin < last ? bin : last]++;
+					}
+				}
+			}
+
+			// The base width is 16 bytes, which any GCC target can lower, to SSE2, NEON or plain registers
+#define __POOLER_SIMD_KERNELS(suffix, target, BYTES) \
+			target inline float sum##suffix(const float* x, std::size_t n) {return sumKernel<float, BYTES>(x, n);} \
+			target inline double sum##suffix(const double* x, std::size_t n) {return sumKernel<double, BYTES>(x, n);} \
+			target inline float dot##suffix(const float* x, const float* y, std::size_t n) {return dotKernel<float, BYTES>(x, y, n);} \
+			target inline double dot##suffix(const double* x, const double* y, std::size_t n) {return dotKernel<double, BYTES>(x, y, n);} \
+			target inline float min##suffix(const float* x, std::size_t n) {return extremeKernel<float, BYTES, false>(x, n);} \
+			target inline double min##suffix(const double* x, std::size_t n) {return extremeKernel<double, BYTES, false>(x, n);} \
+			target inline float max##suffix(const float* x, std::size_t n) {return extremeKernel<float, BYTES, true>(x, n);} \
+			target inline double max##suffix(const double* x, std::size_t n) {return extremeKernel<double, BYTES, true>(x, n);} \
+			target inline void axpy##suffix(float a, const float* x, float* y, std::size_t n) {axpyKernel<float, BYTES>(a, x, y, n);} \
+			target inline void axpy##suffix(double a, const double* x, double* y, std::size_t n) {axpyKernel<double, BYTES>(a, x, y, n);} \
+			target inline void histogram##suffix(const float* x, std::size_t n, float low, float high, uint64_t* counts, uint32_t bins) {histogramKernel<BYTES>(x, n, low, high, counts, bins);}
+
+			__POOLER_SIMD_KERNELS(Base, , 16)
+#ifdef POOLER_SIMD_X86
+			__POOLER_SIMD_KERNELS(Avx2, __POOLER_TARGET("avx2,fma"), 32)
+			__POOLER_SIMD_KERNELS(Avx512, __POOLER_TARGET("avx512f"), 64)
+#endif
+#undef __POOLER_SIMD_KERNELS
+
+#define __POOLER_SIMD_DISPATCH(kernel, ...) \
+			switch (isa()) { \
+				case AVX512: return detail::kernel##Avx512(__VA_ARGS__); \
+				case AVX2: return detail::kernel##Avx2(__VA_ARGS__); \
+				case SSE2: return detail::kernel##Base(__VA_ARGS__); \
+				default: return detail::kernel##Scalar(__VA_ARGS__); \
+			}
+#ifndef POOLER_SIMD_X86
+#undef __POOLER_SIMD_DISPATCH
+#define __POOLER_SIMD_DISPATCH(kernel, ...) return detail::kernel##Base(__VA_ARGS__);
+#endif
+#else
+#define __POOLER_SIMD_DISPATCH(kernel, ...) return detail::kernel##Scalar(__VA_ARGS__);
+#endif
+		}
+
+		/* @brief Add up an array
+		 */
+		inline float sum(const float* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(sum, x, n)
+		}
+
+		inline double sum(const double* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(sum, x, n)
+		}
+
+		/* @brief The dot product of two arrays
+		 */
+		inline float dot(const float* x, const float* y, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(dot, x, y, n)
+		}
+
+		inline double dot(const double* x, const double* y, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(dot, x, y, n)
+		}
+
+		/* @brief The smallest element of an array, or infinity if it is empty. NaNs give an unspecified result
+		 */
+		inline float min(const float* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(min, x, n)
+		}
+
+		inline double min(const double* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(min, x, n)
+		}
+
+		/* @brief The largest element of an array, or minus infinity if it is empty. NaNs give an unspecified result
+		 */
+		inline float max(const float* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(max, x, n)
+		}
+
+		inline double max(const double* x, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(max, x, n)
+		}
+
+		/* @brief y += a * x, element by element
+		 */
+		inline void axpy(float a, const float* x, float* y, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(axpy, a, x, y, n)
+		}
+
+		inline void axpy(double a, const double* x, double* y, std::size_t n) {
+			__POOLER_SIMD_DISPATCH(axpy, a, x, y, n)
+		}
+
+		/* @brief Count the elements of an array falling in each of a number of equal bins over [low, high)
+		 * @param[in] x	The array
+		 * @param[in] n	The length of the array
+		 * @param[in] low	The bottom of the first bin
+		 * @param[in] high	The top of the last bin. Elements outside [low, high) are not counted
+		 * @param[in,out] counts	The count of every bin, which is added to
+		 * @param[in] bins	The number of bins
+		 */
+		inline void histogram(const float* x, std::size_t n, float low, float high, uint64_t* counts, uint32_t bins) {
+			__POOLER_SIMD_DISPATCH(histogram, x, n, low, high, counts, bins)
+		}
+
+#undef __POOLER_SIMD_DISPATCH
+	}
+
+	/* @brief Add up an array in parallel, each thread summing its block with the vector kernel
+	 */
+	template<class Pool, class T>
+	T parallel_sum(Pool& pool, const T* x, std::size_t n) {
+		return parallel_reduce_blocks(pool, x, x + n, T(0), [](const T* begin, const T* end) {
+			return simd::sum(begin, std::size_t(end - begin));
+		}, [](T a, T b) {return a + b;});
+	}
+
+	/* @brief The dot product of two arrays, in parallel
+	 */
+	template<class Pool, class T>
+	T parallel_dot(Pool& pool, const T* x, const T* y, std::size_t n) {
+		return parallel_reduce_blocks(pool, x, x + n, T(0), [=](const T* begin, const T* end) {
+			return simd::dot(begin, y + (begin - x), std::size_t(end - begin));
+		}, [](T a, T b) {return a + b;});
+	}
+
+	/* @brief The smallest element of an array, in parallel, or infinity if it is empty
+	 */
+	template<class Pool, class T>
+	T parallel_min(Pool& pool, const T* x, std::size_t n) {
+		return parallel_reduce_blocks(pool, x, x + n, std::numeric_limits<T>::infinity(), [](const T* begin, const T* end) {
+			return simd::min(begin, std::size_t(end - begin));
+		}, [](T a, T b) {return b < a ? b : a;});
+	}
+
+	/* @brief The largest element of an array, in parallel, or minus infinity if it is empty
+	 */
+	template<class Pool, class T>
+	T parallel_max(Pool& pool, const T* x, std::size_t n) {
+		return parallel_reduce_blocks(pool, x, x + n, -std::numeric_limits<T>::infinity(), [](const T* begin, const T* end) {
+			return simd::max(begin, std::size_t(end - begin));
+		}, [](T a, T b) {return b > a ? b : a;});
+	}
+
+	/* @brief y += a * x in parallel, each thread updating its block with the vector kernel
+	 */
+	template<class Pool, class T>
+	void parallel_axpy(Pool& pool, T a, const T* x, T* y, std::size_t n) {
+		parallel_transform_blocks(pool, x, x + n, y, [=](const T* begin, const T* end, T* out) {
+			simd::axpy(a, begin, out, std::size_t(end - begin));
+		});
+	}
+
+	/* @brief Count the elements of an array falling in each of a number of equal bins over [low, high), in parallel
+	 * @description Every thread counts its block into its own bins, which are added to counts at the end. 
+	 */
+	template<class Pool>
+	void parallel_histogram(Pool& pool, const float* x, std::size_t n, float low, float high, uint64_t* counts, uint32_t bins) {
+		typedef std::vector<uint64_t> bins_t;
+		const bins_t total = parallel_reduce_blocks(pool, x, x + n, bins_t(bins, 0), [=](const float* begin, const float* end) {
+			bins_t local(bins, 0);
+			simd::histogram(begin, std::size_t(end - begin), low, high, local.data(), bins);
+			return local;
+		}, [](bins_t a, const bins_t& b) {
+			for (std::size_t i=0;i<a.size();i++) {
+				a[i] += b[i];
+			}
+			return a;
+		});
+
+		for (uint32_t i=0;i<bins;i++) {
+			counts[i] += total[i];
+		}
+	}
+}
+
+#endif